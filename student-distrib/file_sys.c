@@ -7,7 +7,23 @@
 boot_block_t *boot_block;
 inode_t * inode;
 uint32_t data_blocks;
-uint32_t dentry_counter;
+uint32_t extent_fs;
+
+// open-addressed name index over boot_block->direntries, each slot holds a dentry index or DENTRY_HASH_EMPTY
+uint8_t dentry_hash[DENTRY_HASH_SIZE];
+
+// one bit per inode and per data block of the image, set while it is free
+static uint32_t inode_bitmap[FS_MAX_INODES / FS_WORD_BITS];
+static uint32_t block_bitmap[FS_MAX_DATA_BLOCKS / FS_WORD_BITS];
+uint32_t fs_free_inode_count;
+uint32_t fs_free_block_count;
+
+// bitmap words to start searching from, every word before them is known to be empty
+static uint32_t first_free_inode_word;
+static uint32_t first_free_block_word;
+
+static void build_free_bitmaps();
+static void free_block(uint32_t block_num);
 
 /* void init_file_sys(uint32_t starting_addr)
  * Inputs: uint32_t starting_addr = starting address of file system
@@ -18,51 +34,358 @@ void init_file_sys(uint32_t starting_addr) {
     boot_block= (boot_block_t *) starting_addr;
     inode = (inode_t *)(starting_addr + BYTES_PER_BLOCK); // starting inode address
     data_blocks = (starting_addr + BYTES_PER_BLOCK + boot_block->inode_count * BYTES_PER_BLOCK); // starting data blocks address
-    dentry_counter = 0;
+    extent_fs = (*(uint32_t *) boot_block->reserved == FS_EXTENT_MAGIC);
+    build_dentry_hash();
+    build_free_bitmaps();
+}
+
+/* void bitmap_free(uint32_t* bitmap, uint32_t index, uint32_t* first_free_word, uint32_t* free_count)
+ * Inputs: uint32_t* bitmap: inode_bitmap or block_bitmap
+ *         uint32_t index: inode or data block number to mark free
+ *         uint32_t* first_free_word, uint32_t* free_count: the bitmap's search start and free counter
+ * Return Value: none
+ * Function: Marks an inode or data block free, ignoring ones that already are
+ */
+static void bitmap_free(uint32_t* bitmap, uint32_t index, uint32_t* first_free_word, uint32_t* free_count) {
+    uint32_t word = index / FS_WORD_BITS;
+    uint32_t mask = 1 << (index % FS_WORD_BITS);
+
+    if (bitmap[word] & mask) {
+        return;
+    }
+    bitmap[word] |= mask;
+    (*free_count)++;
+    if (word < *first_free_word) {
+        *first_free_word = word;
+    }
+}
+
+/* int32_t bitmap_alloc(uint32_t* bitmap, uint32_t num_words, uint32_t* first_free_word, uint32_t* free_count)
+ * Inputs: uint32_t* bitmap: inode_bitmap or block_bitmap
+ *         uint32_t num_words: words of the bitmap in use
+ *         uint32_t* first_free_word, uint32_t* free_count: the bitmap's search start and free counter
+ * Return Value: the inode or data block number now marked used, -1 if none are free
+ * Function: Finds a free bit a word at a time, starting from the first word that can have one
+ */
+static int32_t bitmap_alloc(uint32_t* bitmap, uint32_t num_words, uint32_t* first_free_word, uint32_t* free_count) {
+    uint32_t word;
+    uint32_t bit;
+
+    for (word = *first_free_word; word < num_words; word++) {
+        if (bitmap[word] != 0) {
+            asm volatile("bsfl %1, %0" : "=r" (bit) : "r" (bitmap[word]));
+            bitmap[word] &= ~(1 << bit);
+            (*free_count)--;
+            *first_free_word = word;
+            return word * FS_WORD_BITS + bit;
+        }
+    }
+    *first_free_word = num_words;
+    return -1;
+}
+
+/* inode_t* get_inode(uint32_t inode_num)
+ * Inputs: uint32_t inode_num: inode number, already checked against inode_count
+ * Return Value: the inode's block in the image, an extent_inode_t when extent_fs is set
+ * Function: Finds an inode
+ */
+static inode_t* get_inode(uint32_t inode_num) {
+    return (inode_t*) ((uint32_t) inode + inode_num * BYTES_PER_BLOCK);
+}
+
+/* extent_t* inode_extent(extent_inode_t* cur_inode, uint32_t index)
+ * Inputs: extent_inode_t* cur_inode: inode of an extent format image
+ *         uint32_t index: extent number, below MAX_EXTENTS
+ * Return Value: the extent, in the inode or in its indirect block
+ * Function: Finds the index-th extent of a file
+ */
+static extent_t* inode_extent(extent_inode_t* cur_inode, uint32_t index) {
+    if (index < INODE_EXTENTS) {
+        return &cur_inode->extents[index];
+    }
+    return (extent_t*) (data_blocks + cur_inode->indirect_block * BYTES_PER_BLOCK) + (index - INODE_EXTENTS);
+}
+
+/* int32_t file_block(inode_t* cur_inode, uint32_t index, uint32_t max_run, uint32_t* run)
+ * Inputs: inode_t* cur_inode: inode of the file, in either format
+ *         uint32_t index: block index within the file
+ *         uint32_t max_run: most blocks the caller wants to know about
+ *         uint32_t* run: loaded with the number of the file's blocks, starting at index, that follow each other
+ *                        in the image, at least 1 and at most max_run
+ * Return Value: data block number of block index, -1 on a bad data block number or an index past the file's blocks
+ * Function: Maps file blocks to data blocks. A flat inode is scanned for consecutive block numbers;
+ *           an extent says how far its run goes, so a contiguous file comes back as one run.
+ */
+static int32_t file_block(inode_t* cur_inode, uint32_t index, uint32_t max_run, uint32_t* run) {
+    extent_inode_t* cur_extent_inode = (extent_inode_t*) cur_inode;
+    extent_t* extent;
+    uint32_t block_num;
+    uint32_t i;
+    uint32_t first = 0; // file block index of the current extent's first block
+
+    if (!extent_fs) {
+        if (index >= MAX_FILE_BLOCKS || (block_num = cur_inode->data_block_num[index]) >= boot_block->data_count) {
+            return -1;
+        }
+        for (*run = 1; *run < max_run && index + *run < MAX_FILE_BLOCKS && block_num + *run < boot_block->data_count &&
+             cur_inode->data_block_num[index + *run] == block_num + *run; (*run)++);
+        return block_num;
+    }
+
+    for (i = 0; i < cur_extent_inode->num_extents && i < MAX_EXTENTS; i++) {
+        extent = inode_extent(cur_extent_inode, i);
+        if (index < first + extent->length) {
+            block_num = extent->start + (index - first);
+            *run = extent->length - (index - first);
+            if (*run > max_run) {
+                *run = max_run;
+            }
+            if (block_num >= boot_block->data_count || *run > boot_block->data_count - block_num) {
+                return -1;
+            }
+            return block_num;
+        }
+        first += extent->length;
+    }
+    return -1;
+}
+
+/* int32_t file_append_block(inode_t* cur_inode, uint32_t blocks, uint32_t block_num)
+ * Inputs: inode_t* cur_inode: inode of the file, in either format
+ *         uint32_t blocks: data blocks the file has now
+ *         uint32_t block_num: data block to add after them
+ * Return Value: 0 (success), -1 if the inode has no room for it
+ * Function: Makes block_num the file's next block. In the extent format it grows the last extent when the block
+ *           follows it in the image, and otherwise starts a new extent, taking an indirect block when the inode is full.
+ */
+static int32_t file_append_block(inode_t* cur_inode, uint32_t blocks, uint32_t block_num);
+
+/* void for_each_file_block(inode_t* cur_inode, void (*fn)(uint32_t block_num))
+ * Inputs: inode_t* cur_inode: inode of the file, in either format
+ *         void (*fn)(uint32_t block_num): called for every data block the file uses, its indirect extent block included
+ * Return Value: none
+ * Function: Walks a file's data blocks for the bitmaps, skipping block numbers outside the image
+ */
+static void for_each_file_block(inode_t* cur_inode, void (*fn)(uint32_t block_num)) {
+    extent_inode_t* cur_extent_inode = (extent_inode_t*) cur_inode;
+    extent_t* extent;
+    uint32_t i, j;
+
+    if (!extent_fs) {
+        for (i = 0; i * BYTES_PER_BLOCK < cur_inode->length && i < MAX_FILE_BLOCKS; i++) {
+            if (cur_inode->data_block_num[i] < boot_block->data_count) {
+                fn(cur_inode->data_block_num[i]);
+            }
+        }
+        return;
+    }
+
+    if (cur_extent_inode->num_extents > INODE_EXTENTS && cur_extent_inode->indirect_block >= boot_block->data_count) {
+        cur_extent_inode->num_extents = INODE_EXTENTS; // the rest of the extents can't be found
+    }
+    for (i = 0; i < cur_extent_inode->num_extents && i < MAX_EXTENTS; i++) {
+        extent = inode_extent(cur_extent_inode, i);
+        for (j = 0; j < extent->length && extent->start + j < boot_block->data_count; j++) {
+            fn(extent->start + j);
+        }
+    }
+    if (cur_extent_inode->num_extents > INODE_EXTENTS) {
+        fn(cur_extent_inode->indirect_block);
+    }
+}
+
+/* void take_block(uint32_t block_num)
+ * Inputs: uint32_t block_num: data block a file uses
+ * Return Value: none
+ * Function: Marks a data block used while the bitmaps are built
+ */
+static void take_block(uint32_t block_num) {
+    uint32_t mask = 1 << (block_num % FS_WORD_BITS);
+
+    if (block_num < FS_MAX_DATA_BLOCKS && (block_bitmap[block_num / FS_WORD_BITS] & mask)) {
+        block_bitmap[block_num / FS_WORD_BITS] &= ~mask;
+        fs_free_block_count--;
+    }
+}
+
+/* void free_block(uint32_t block_num)
+ * Inputs: uint32_t block_num: data block an unlinked file used
+ * Return Value: none
+ * Function: Marks a data block free
+ */
+static void free_block(uint32_t block_num) {
+    if (block_num < FS_MAX_DATA_BLOCKS) {
+        bitmap_free(block_bitmap, block_num, &first_free_block_word, &fs_free_block_count);
+    }
+}
+
+/* int32_t alloc_block()
+ * Inputs: none
+ * Return Value: a zeroed data block now marked used, -1 if the image is full
+ * Function: Takes the first free data block
+ */
+static int32_t alloc_block() {
+    int32_t block_num = bitmap_alloc(block_bitmap, FS_MAX_DATA_BLOCKS / FS_WORD_BITS, &first_free_block_word, &fs_free_block_count);
+
+    if (block_num == -1 || (uint32_t) block_num >= boot_block->data_count) {
+        return -1;
+    }
+    memset((uint8_t *) (data_blocks + block_num * BYTES_PER_BLOCK), 0, BYTES_PER_BLOCK);
+    return block_num;
+}
+
+static int32_t file_append_block(inode_t* cur_inode, uint32_t blocks, uint32_t block_num) {
+    extent_inode_t* cur_extent_inode = (extent_inode_t*) cur_inode;
+    extent_t* extent;
+    int32_t indirect;
+
+    if (!extent_fs) {
+        if (blocks >= MAX_FILE_BLOCKS) {
+            return -1;
+        }
+        cur_inode->data_block_num[blocks] = block_num;
+        return 0;
+    }
+
+    if (cur_extent_inode->num_extents > 0) {
+        extent = inode_extent(cur_extent_inode, cur_extent_inode->num_extents - 1);
+        if (extent->start + extent->length == block_num) {
+            extent->length++;
+            return 0;
+        }
+    }
+    if (cur_extent_inode->num_extents >= MAX_EXTENTS) {
+        return -1;
+    }
+    if (cur_extent_inode->num_extents == INODE_EXTENTS) {
+        if ((indirect = alloc_block()) == -1) {
+            return -1;
+        }
+        cur_extent_inode->indirect_block = indirect;
+    }
+    extent = inode_extent(cur_extent_inode, cur_extent_inode->num_extents);
+    extent->start = block_num;
+    extent->length = 1;
+    cur_extent_inode->num_extents++;
+    return 0;
+}
+
+/* void build_free_bitmaps()
+ * Inputs: none
+ * Return Value: none
+ * Function: createfs doesn't record what is free, so every inode and data block of the image starts out free
+ *           and the ones the regular files' dentries reach are taken back out. Inode 0 stays reserved since
+ *           the RTC and directory dentries point at it.
+ */
+static void build_free_bitmaps() {
+    uint32_t inode_count = (boot_block->inode_count < FS_MAX_INODES) ? boot_block->inode_count : FS_MAX_INODES;
+    uint32_t data_count = (boot_block->data_count < FS_MAX_DATA_BLOCKS) ? boot_block->data_count : FS_MAX_DATA_BLOCKS;
+    dentry_t* dentry;
+    uint32_t mask;
+    uint32_t i;
+
+    memset(inode_bitmap, 0, sizeof(inode_bitmap));
+    memset(block_bitmap, 0, sizeof(block_bitmap));
+    fs_free_inode_count = 0;
+    fs_free_block_count = 0;
+    first_free_inode_word = 0;
+    first_free_block_word = 0;
+    for (i = 1; i < inode_count; i++) {
+        bitmap_free(inode_bitmap, i, &first_free_inode_word, &fs_free_inode_count);
+    }
+    for (i = 0; i < data_count; i++) {
+        bitmap_free(block_bitmap, i, &first_free_block_word, &fs_free_block_count);
+    }
+
+    for (i = 0; i < boot_block->dir_count && i < DIR_ENTRIES; i++) {
+        dentry = &boot_block->direntries[i];
+        if (dentry->filetype != REGULAR_FILE || dentry->inode_num >= inode_count) {
+            continue;
+        }
+        mask = 1 << (dentry->inode_num % FS_WORD_BITS);
+        if (inode_bitmap[dentry->inode_num / FS_WORD_BITS] & mask) {
+            inode_bitmap[dentry->inode_num / FS_WORD_BITS] &= ~mask;
+            fs_free_inode_count--;
+        }
+        for_each_file_block(get_inode(dentry->inode_num), take_block);
+    }
+}
+
+/* uint32_t dentry_name_hash(const uint8_t* name, uint32_t* name_len)
+ * Inputs: const uint8_t* name: file name, ends at a '\0' or after FILENAME_LEN characters
+ *         uint32_t* name_len: loaded with the length of the name, FILENAME_LEN + 1 if it is too long
+ * Return Value: FNV-1a hash of the name
+ * Function: Hashes a file name the same way whether it comes from a dentry or from a caller
+ */
+uint32_t dentry_name_hash(const uint8_t* name, uint32_t* name_len) {
+    uint32_t hash = FNV_OFFSET_BASIS;
+    uint32_t i;
+
+    for (i = 0; i < FILENAME_LEN && name[i] != '\0'; i++) {
+        hash = (hash ^ name[i]) * FNV_PRIME;
+    }
+    // a caller's name that keeps going past FILENAME_LEN can't match any dentry
+    if (i == FILENAME_LEN && name_len != NULL && name[i] != '\0') {
+        i++;
+    }
+    if (name_len != NULL) {
+        *name_len = i;
+    }
+    return hash;
+}
+
+/* void build_dentry_hash()
+ * Inputs: none
+ * Return Value: none
+ * Function: Inserts every dentry into the name index. Entries are inserted in directory order,
+ *           so with linear probing a lookup still finds the first dentry with a given name.
+ */
+void build_dentry_hash() {
+    uint32_t i;
+    uint32_t slot;
+
+    for (i = 0; i < DENTRY_HASH_SIZE; i++) {
+        dentry_hash[i] = DENTRY_HASH_EMPTY;
+    }
+
+    for (i = 0; i < boot_block->dir_count && i < DIR_ENTRIES; i++) {
+        slot = dentry_name_hash(boot_block->direntries[i].filename, NULL) & (DENTRY_HASH_SIZE - 1);
+        while (dentry_hash[slot] != DENTRY_HASH_EMPTY) { // table is twice the directory size, so this always ends
+            slot = (slot + 1) & (DENTRY_HASH_SIZE - 1);
+        }
+        dentry_hash[slot] = i;
+    }
 }
 
 /* int32_t read_dentry_by_name (const uint8_t* fname, dentry_t* dentry)
  * Inputs: const uint8_t* fname: file name of file to be read,
  *         dentry_t* dentry: if file is found this is loaded with the correct dentry
  * Return Value: 0 (success: file found), -1 (fail)
- * Function: Finds file dentry by name
+ * Function: Finds file dentry by name using the hashed name index built in init_file_sys
  */
 int32_t read_dentry_by_name (const uint8_t* fname, dentry_t* dentry) {
     dentry_t * dentries_array = boot_block->direntries;
-    int i;
-    int found_flag = 0;
-    dentry_t found_dentry;
-    int len;
+    uint32_t len;
+    uint32_t slot;
+    uint32_t probes;
 
-    if (strlen((int8_t *) fname) == 0) {// check if "" name
+    if (fname == NULL) {
         return -1;
     }
 
-    for(i = 0; i < DIR_ENTRIES; i++) {
-        len = strlen((int8_t *)fname);
-        if(len > FILENAME_LEN) { //check if name is too long
-            return -1;
-        }
-
-        //strncmp assumes same length
-        const int8_t* cur_dentry = (const int8_t*) dentries_array[i].filename;
-        if (strlen((int8_t *) cur_dentry) > len) {
-            len = strlen((int8_t *) cur_dentry);
-            if (len > FILENAME_LEN) {
-                len = FILENAME_LEN;
-            }
-        }
-        // makes sure they are the same string
-        if(strncmp((int8_t *)cur_dentry, (int8_t *)fname, len) == 0) {
-            found_flag = 1; //if so set found flag
-            found_dentry = dentries_array[i]; // set found dentry
-            break;
-        }
+    slot = dentry_name_hash(fname, &len) & (DENTRY_HASH_SIZE - 1);
+    if (len == 0 || len > FILENAME_LEN) { // check if "" name or name is too long
+        return -1;
     }
 
-    if(found_flag == 1) {
-        *dentry = found_dentry; //set load dentry with found dentry
-        return 0; //successful
+    // probe from the name's home slot until we hit it or an empty slot
+    for (probes = 0; probes < DENTRY_HASH_SIZE && dentry_hash[slot] != DENTRY_HASH_EMPTY; probes++) {
+        // dentry names are only null terminated when shorter than FILENAME_LEN
+        if (strncmp((int8_t *) dentries_array[dentry_hash[slot]].filename, (int8_t *) fname, FILENAME_LEN) == 0) {
+            *dentry = dentries_array[dentry_hash[slot]]; //set load dentry with found dentry
+            return 0; //successful
+        }
+        slot = (slot + 1) & (DENTRY_HASH_SIZE - 1);
     }
     return -1; // not found
 }
@@ -92,11 +415,15 @@ int32_t read_dentry_by_index (uint32_t index, dentry_t* dentry) {
  *          uint32_t offset: data offset  in bytes,
  *          uint8_t* buf: char pointer buffer to be filled in by data read,
  *          uint32_t length: length of data to be read up to
- * Return Value: Number of bytes read
+ * Return Value: Number of bytes read, -1 on a bad inode or data block number
  * Function: readS up to length bytes starting from position offset in the file with inode number inode and returning the number of bytes read and placed in the buffer.
+ *           Data is copied in runs: each run covers the rest of the current data block plus any data blocks
+ *           that directly follow it in the image, a whole extent at a time in the extent format.
  */
 int32_t read_data (uint32_t inode_num, uint32_t offset, uint8_t* buf, uint32_t length) {
-    uint32_t i; // loop counter
+    int32_t block_num; // data block number of the start of the current run
+    uint32_t run_blocks; // data blocks in the current run
+    uint32_t run_length; // bytes copied by the current run
 
     /* Case 1: Inode input is greater than the number of inodes we have. */
     if (inode_num >= boot_block->inode_count) {
@@ -106,31 +433,36 @@ int32_t read_data (uint32_t inode_num, uint32_t offset, uint8_t* buf, uint32_t l
     uint32_t inode_block_index = offset / BYTES_PER_BLOCK; // current data block index within inode
     uint32_t data_block_index = offset % BYTES_PER_BLOCK; // index in data block
 
-    int32_t num_bytes_copied = 0; // bytes copied counter
-    inode_t * cur_inode = (inode_t*) ((uint32_t) inode + inode_num * BYTES_PER_BLOCK); // get current inode
+    uint32_t num_bytes_copied = 0; // bytes copied counter
+    inode_t * cur_inode = get_inode(inode_num); // get current inode
     /* Case 2: Offset is greater than the length of our inode. */
     if (offset >= cur_inode->length) {
         return 0;
     }
 
     // Change the length if we will be going over the last data block in the current inode
-    if (offset + length > cur_inode->length) {
+    if (length > cur_inode->length - offset) {
         length = cur_inode->length - offset;
     }
-    
-    for (i = 0; i < length; i++) {
-        // get the address we want and put into src
-        uint8_t * src = (uint8_t *) (data_blocks + cur_inode->data_block_num[inode_block_index] * BYTES_PER_BLOCK + data_block_index);
-        memcpy(buf + num_bytes_copied, src, 1); // copy 1 byte into buffer
-        // iterate counters and index trackers
-        num_bytes_copied++;
-        data_block_index++;
-
-        /* If we reached the end of the current data block, go to the next one */
-        if (data_block_index >= BYTES_PER_BLOCK) {
-            data_block_index = 0;
-            inode_block_index++;
+
+    while (num_bytes_copied < length) {
+        // the run covers as many of the blocks left to copy as follow each other in the image
+        block_num = file_block(cur_inode, inode_block_index,
+                               (data_block_index + length - num_bytes_copied + BYTES_PER_BLOCK - 1) / BYTES_PER_BLOCK, &run_blocks);
+        if (block_num == -1) {
+            return -1;
         }
+        run_length = run_blocks * BYTES_PER_BLOCK - data_block_index;
+        inode_block_index += run_blocks;
+
+        if (run_length > length - num_bytes_copied) {
+            run_length = length - num_bytes_copied;
+        }
+
+        // copy the whole run at once
+        memcpy(buf + num_bytes_copied, (uint8_t *) (data_blocks + block_num * BYTES_PER_BLOCK + data_block_index), run_length);
+        num_bytes_copied += run_length;
+        data_block_index = 0; // every run after the first starts at the beginning of a data block
     }
 
     return num_bytes_copied;
@@ -138,40 +470,374 @@ int32_t read_data (uint32_t inode_num, uint32_t offset, uint8_t* buf, uint32_t l
 
 
 
+/* uint8_t* file_block_addr(uint32_t inode_num, uint32_t offset)
+ * Inputs: uint32_t inode_num: inode of the file
+ *         uint32_t offset: byte offset in the file, rounded down to its data block
+ * Return Value: address of the data block in the file system image, NULL if offset is past the end of the file
+ * Function: Lets the program loader map a file's data blocks straight into user space instead of copying them
+ */
+uint8_t* file_block_addr(uint32_t inode_num, uint32_t offset) {
+    inode_t * cur_inode;
+    int32_t block_num;
+    uint32_t run;
+
+    if (inode_num >= boot_block->inode_count) {
+        return NULL;
+    }
+    cur_inode = get_inode(inode_num);
+    if (offset >= cur_inode->length) {
+        return NULL;
+    }
+    block_num = file_block(cur_inode, offset / BYTES_PER_BLOCK, 1, &run);
+    if (block_num == -1) {
+        return NULL;
+    }
+    return (uint8_t*) (data_blocks + block_num * BYTES_PER_BLOCK);
+}
+
+/* int32_t fs_create(const uint8_t* fname)
+ * Inputs: const uint8_t* fname: name of the new file
+ * Return Value: 0 (success), -1 if the name is bad or taken, or the directory or the inodes are full
+ * Function: Adds an empty regular file with a fresh inode to the end of the directory
+ */
+int32_t fs_create(const uint8_t* fname) {
+    dentry_t dentry;
+    dentry_t* new_dentry;
+    inode_t* cur_inode;
+    uint32_t len;
+    uint32_t flags;
+    int32_t inode_num;
+
+    if (fname == NULL) {
+        return -1;
+    }
+    dentry_name_hash(fname, &len);
+    if (len == 0 || len > FILENAME_LEN) {
+        return -1;
+    }
+
+    cli_and_save(flags);
+    if (read_dentry_by_name(fname, &dentry) == 0 || boot_block->dir_count >= DIR_ENTRIES) {
+        restore_flags(flags);
+        return -1;
+    }
+    inode_num = bitmap_alloc(inode_bitmap, FS_MAX_INODES / FS_WORD_BITS, &first_free_inode_word, &fs_free_inode_count);
+    if (inode_num == -1 || (uint32_t) inode_num >= boot_block->inode_count) {
+        restore_flags(flags);
+        return -1;
+    }
+    cur_inode = get_inode(inode_num);
+    cur_inode->length = 0;
+    ((extent_inode_t*) cur_inode)->num_extents = 0; // the first data block number in the flat format, unused until then
+
+    new_dentry = &boot_block->direntries[boot_block->dir_count];
+    memset(new_dentry, 0, sizeof(dentry_t));
+    memcpy(new_dentry->filename, fname, len); // not null terminated when it is FILENAME_LEN long, like createfs
+    new_dentry->filetype = REGULAR_FILE;
+    new_dentry->inode_num = inode_num;
+    boot_block->dir_count++;
+    build_dentry_hash();
+    restore_flags(flags);
+    return 0;
+}
+
+/* static void dir_cursors_removed(uint32_t index)
+ * Inputs:  uint32_t index: directory index of a dentry that was just removed
+ * Return Value: none
+ * Function: Moves every open directory cursor past the removed dentry back one, so the dentries that slid
+ *           down don't get skipped.
+ */
+static void dir_cursors_removed(uint32_t index) {
+    pcb_t* pcb;
+    fd_t* file;
+    int i, j;
+
+    for (i = 0; i < NUM_PROCESSES; i++) {
+        if (!cur_processes[i]) {
+            continue;
+        }
+        pcb = get_pcb(i);
+        for (j = 0; j < FILE_DESCRIPTOR_MAX; j++) {
+            file = &pcb->file_descriptors[j];
+            if (file->flags != NOT_IN_USE && file->file_op_table_ptr == &dir_ops && file->file_pos > (int32_t) index) {
+                file->file_pos--;
+            }
+        }
+    }
+}
+
+/* int32_t fs_unlink(const uint8_t* fname)
+ * Inputs: const uint8_t* fname: name of a regular file
+ * Return Value: 0 (success), -1 if there is no such regular file
+ * Function: Removes the file's dentry, sliding the later dentries down one so the directory keeps its order,
+ *           and frees its inode and data blocks. The caller makes sure nobody has the file open or is running it.
+ */
+int32_t fs_unlink(const uint8_t* fname) {
+    dentry_t* dentries_array = boot_block->direntries;
+    inode_t* cur_inode;
+    uint32_t index;
+    uint32_t flags;
+
+    if (fname == NULL) {
+        return -1;
+    }
+
+    cli_and_save(flags);
+    for (index = 0; index < boot_block->dir_count; index++) {
+        if (strncmp((int8_t *) dentries_array[index].filename, (int8_t *) fname, FILENAME_LEN) == 0) {
+            break;
+        }
+    }
+    if (index == boot_block->dir_count || dentries_array[index].filetype != REGULAR_FILE ||
+        dentries_array[index].inode_num >= boot_block->inode_count) {
+        restore_flags(flags);
+        return -1;
+    }
+
+    cur_inode = get_inode(dentries_array[index].inode_num);
+    for_each_file_block(cur_inode, free_block);
+    cur_inode->length = 0;
+    if (dentries_array[index].inode_num < FS_MAX_INODES) {
+        bitmap_free(inode_bitmap, dentries_array[index].inode_num, &first_free_inode_word, &fs_free_inode_count);
+    }
+
+    boot_block->dir_count--;
+    memmove(&dentries_array[index], &dentries_array[index + 1], (boot_block->dir_count - index) * sizeof(dentry_t));
+    dir_cursors_removed(index);
+    build_dentry_hash();
+    restore_flags(flags);
+    return 0;
+}
+
+/* int32_t file_cursor_seek(fd_t* file, uint32_t pos)
+ * Inputs:  fd_t* file: open data file,
+ *          uint32_t pos: file position to move the cursor to, before the end of the file
+ * Return Value: 0 (success), -1 on a bad data block number
+ * Function: Points the cursor at the data block holding pos and reads ahead in the inode: the window covers
+ *           up to READ_AHEAD_BLOCKS data blocks that follow each other in the image, or the rest of the extent
+ *           in the extent format, so sequential reads copy straight through it without going back to the inode.
+ */
+static int32_t file_cursor_seek(fd_t* file, uint32_t pos) {
+    inode_t * cur_inode = get_inode(file->inode);
+    uint32_t blocks;
+    // an extent already says how far it goes, a flat inode is only scanned a window ahead
+    int32_t block_num = file_block(cur_inode, pos / BYTES_PER_BLOCK, extent_fs ? EXTENT_MAX_FILE_BYTES / BYTES_PER_BLOCK : READ_AHEAD_BLOCKS, &blocks);
+
+    if (block_num == -1) {
+        file->cursor_block = NULL;
+        return -1;
+    }
+
+    file->cursor_block = (uint8_t *) (data_blocks + block_num * BYTES_PER_BLOCK);
+    file->cursor_offset = pos % BYTES_PER_BLOCK;
+    file->cursor_pos = pos;
+    file->cursor_run = blocks * BYTES_PER_BLOCK - file->cursor_offset;
+    // the window never runs past the end of the file
+    if (file->cursor_run > cur_inode->length - pos) {
+        file->cursor_run = cur_inode->length - pos;
+    }
+    return 0;
+}
+
 /* int32_t read_file(int32_t fd, void* buf, int32_t nbytes)
  * Inputs:  int32_t fd: file descriptor array index,   
  *          void* buf: void pointer buffer to be filled in by data read,
  *          int32_t nbytes: Number of bytes  to be read
- * Return Value: number of bytes read
+ * Return Value: number of bytes read, -1 on a bad fd or data block number
  * Function: reads nbytes starting from file position offset in the file using fd index and returning the number of bytes read and placed in the buffer.
+ *           A read that starts where the last one ended picks up at the fd's cursor, so it costs the same
+ *           at any offset; the inode is only consulted when the cursor's read-ahead window runs out.
  */
 int32_t read_file(int32_t fd, void* buf, int32_t nbytes) {
-    int offset;
-    int32_t bytes_read;
+    uint32_t offset;
+    uint32_t length;
+    uint32_t run_length; // bytes copied from the current window
+    uint32_t bytes_read = 0;
     uint8_t * buffer = (uint8_t*) buf;
-    pcb_t *pcb = get_pcb(terminal_array[curr_terminal].pid);
+    pcb_t *pcb = get_pcb(curr_pid);
+    fd_t *file;
+    inode_t *cur_inode;
+
+    if(fd >= FILE_DESCRIPTOR_MAX || fd < 0 || nbytes < 0) { //check if valid fd index
+        return -1;
+    }
+
+    file = &pcb->file_descriptors[fd];
+    if ((uint32_t) file->inode >= boot_block->inode_count) {
+        return -1;
+    }
+    cur_inode = get_inode(file->inode);
+
+    offset = file->file_pos; //offset based on file position
+    if (offset >= cur_inode->length) {
+        return 0;
+    }
+    length = cur_inode->length - offset;
+    if (length > (uint32_t) nbytes) {
+        length = nbytes;
+    }
 
-    if(fd >= FILE_DESCRIPTOR_MAX || fd < 0) { //check if valid fd index
+    // somebody moved the file position, or this is the first read
+    if ((file->cursor_block == NULL || file->cursor_pos != offset) && file_cursor_seek(file, offset) == -1) {
         return -1;
     }
-    else{
-        offset = pcb->file_descriptors[fd].file_pos; //offset based on file position
-        pcb->file_descriptors[fd].file_pos += nbytes; //updating file position
-        bytes_read = read_data(pcb->file_descriptors[fd].inode, offset, buffer, nbytes); // call read data to fill our buffer
-        return bytes_read;
-    }  
+
+    while (bytes_read < length) {
+        if (file->cursor_run == 0 && file_cursor_seek(file, file->cursor_pos) == -1) {
+            return -1;
+        }
+        run_length = file->cursor_run;
+        if (run_length > length - bytes_read) {
+            run_length = length - bytes_read;
+        }
+        memcpy(buffer + bytes_read, file->cursor_block + file->cursor_offset, run_length);
+        bytes_read += run_length;
+
+        // advance the cursor, keeping cursor_offset inside cursor_block
+        file->cursor_pos += run_length;
+        file->cursor_run -= run_length;
+        file->cursor_offset += run_length;
+        file->cursor_block += (file->cursor_offset / BYTES_PER_BLOCK) * BYTES_PER_BLOCK;
+        file->cursor_offset %= BYTES_PER_BLOCK;
+    }
+    file->file_pos = offset + bytes_read; // a short read at the end of the file stops there
+    return bytes_read;
+}
+
+/* int32_t lseek_file(int32_t fd, int32_t offset, int32_t whence)
+ * Inputs:  int32_t fd: file descriptor array index of an open regular file,
+ *          int32_t offset: bytes to move by, may be negative,
+ *          int32_t whence: SEEK_SET, SEEK_CUR or SEEK_END, what offset is relative to
+ * Return Value: the new file position, -1 on a bad whence or a position below 0 or past FILE_POS_MAX
+ * Function: moves the file position reads and writes start at. Seeking past the end is allowed; a read
+ *           there returns 0 and a write fills the gap with zeroes. The cursor catches up on the next read.
+ */
+int32_t lseek_file(int32_t fd, int32_t offset, int32_t whence) {
+    pcb_t *pcb = get_pcb(curr_pid);
+    fd_t *file = &pcb->file_descriptors[fd];
+    int32_t base;
+
+    switch (whence) {
+        case SEEK_SET:
+            base = 0;
+            break;
+        case SEEK_CUR:
+            base = file->file_pos;
+            break;
+        case SEEK_END:
+            if ((uint32_t) file->inode >= boot_block->inode_count) {
+                return -1;
+            }
+            base = get_inode(file->inode)->length;
+            break;
+        default:
+            return -1;
+    }
+
+    if (offset < -base || (offset > 0 && offset > FILE_POS_MAX - base)) {
+        return -1;
+    }
+    file->file_pos = base + offset;
+    return file->file_pos;
+}
+
+/* int32_t pread_file(int32_t fd, void* buf, int32_t nbytes, int32_t offset)
+ * Inputs:  int32_t fd: file descriptor array index of an open regular file,
+ *          void* buf: void pointer buffer to be filled in by data read,
+ *          int32_t nbytes: Number of bytes to be read,
+ *          int32_t offset: where in the file to start
+ * Return Value: number of bytes read, -1 on a bad argument or data block number
+ * Function: reads at an arbitrary offset without moving the file position or the cursor, so a reader
+ *           jumping around a file only touches the data blocks it asks for.
+ */
+int32_t pread_file(int32_t fd, void* buf, int32_t nbytes, int32_t offset) {
+    pcb_t *pcb = get_pcb(curr_pid);
+
+    if (nbytes < 0 || offset < 0) {
+        return -1;
+    }
+    return read_data(pcb->file_descriptors[fd].inode, offset, (uint8_t*) buf, nbytes);
 }
 
 /* int32_t write_file(int32_t fd, const void* buf, int32_t nbytes)
  * Inputs:  int32_t fd: file descriptor array index,   
  *          void* buf: void pointer buffer,
  *          int32_t nbytes: Number of bytes  to be written
- * Return Value: -1
- * Function: does nothing since read only file system
+ * Return Value: number of bytes written, which is less than nbytes if the image runs out of data blocks;
+ *               -1 on a bad fd, a full image, or a file that a process is running
+ * Function: writes nbytes at the file position and moves it past them. Data blocks are allocated,
+ *           zeroed, as the file grows past the last one it has.
  */
 int32_t write_file(int32_t fd, const void* buf, int32_t nbytes) {
-    // do nothing
-    return -1;
+    pcb_t *pcb = get_pcb(curr_pid);
+    fd_t *file;
+    inode_t *cur_inode;
+    uint32_t pos;
+    uint32_t blocks; // data blocks the file has
+    uint32_t block_index;
+    uint32_t run_length;
+    uint32_t run;
+    uint32_t bytes_written = 0;
+    uint32_t max_length = extent_fs ? EXTENT_MAX_FILE_BYTES : MAX_FILE_BLOCKS * BYTES_PER_BLOCK;
+    uint32_t flags;
+    int32_t block_num;
+
+    if (fd >= FILE_DESCRIPTOR_MAX || fd < 0 || buf == NULL || nbytes < 0) {
+        return -1;
+    }
+    file = &pcb->file_descriptors[fd];
+    // its pages may be mapped straight from the image into the process
+    if ((uint32_t) file->inode >= boot_block->inode_count || inode_mapped(file->inode)) {
+        return -1;
+    }
+    cur_inode = get_inode(file->inode);
+    pos = file->file_pos;
+    if (pos > max_length || (uint32_t) nbytes > max_length - pos) {
+        return -1;
+    }
+
+    cli_and_save(flags);
+    blocks = (cur_inode->length + BYTES_PER_BLOCK - 1) / BYTES_PER_BLOCK;
+    while (bytes_written < (uint32_t) nbytes) {
+        block_index = pos / BYTES_PER_BLOCK;
+        // grow the file a block at a time, through any gap between its end and pos too
+        while (blocks <= block_index) {
+            if ((block_num = alloc_block()) == -1) {
+                break;
+            }
+            if (file_append_block(cur_inode, blocks, block_num) == -1) {
+                free_block(block_num);
+                break;
+            }
+            blocks++;
+            // a block of the gap is part of the file now, all zeros
+            if (blocks <= block_index) {
+                cur_inode->length = blocks * BYTES_PER_BLOCK;
+            }
+        }
+        if (blocks <= block_index || (block_num = file_block(cur_inode, block_index, 1, &run)) == -1) {
+            break; // out of data blocks
+        }
+
+        run_length = BYTES_PER_BLOCK - pos % BYTES_PER_BLOCK;
+        if (run_length > nbytes - bytes_written) {
+            run_length = nbytes - bytes_written;
+        }
+        memcpy((uint8_t *) (data_blocks + block_num * BYTES_PER_BLOCK + pos % BYTES_PER_BLOCK),
+               (const uint8_t *) buf + bytes_written, run_length);
+        bytes_written += run_length;
+        pos += run_length;
+        if (pos > cur_inode->length) {
+            cur_inode->length = pos;
+        }
+    }
+    file->file_pos = pos;
+    restore_flags(flags);
+
+    if (bytes_written == 0 && nbytes > 0) {
+        return -1;
+    }
+    return bytes_written;
 }
 
 /* int32_t open_file(const uint8_t* filename)
@@ -193,40 +859,78 @@ int32_t close_file(int32_t fd) {
 }
 
 
-/* int32_t read_directory(int32_t fd, void* buf, void* length_buf, int32_t nbytes)
+/* int32_t read_directory(int32_t fd, void* buf, int32_t nbytes)
  * Inputs:  int32_t fd: file descriptor array index, 
  *          void* buf: void pointer buffer to be filled in by data read,
- *          void* length_buf: void pointer length buffer
  *          int32_t nbytes: number of bytes to be read
- * Return Value:  number of bytes read
- * Function: reads directory information
+ * Return Value:  number of bytes read, 0 once every entry has been read
+ * Function: reads the name of the next directory entry. The fd's file_pos is the index of that entry,
+ *           so every open of the directory iterates on its own.
  */
 int32_t read_directory(int32_t fd, void* buf, int32_t nbytes) {
-    // loop counter
-    uint32_t j;
-    // casting the buffer
-    uint8_t * buffer = (uint8_t*) buf;
-    // counters so we know what index to put in buffer
-    uint32_t num_read = 0;
-    pcb_t *pcb = get_pcb(terminal_array[curr_terminal].pid);
+    pcb_t *pcb = get_pcb(curr_pid);
+    fd_t *file = &pcb->file_descriptors[fd];
+    dentry_t dentry;
+    uint32_t num_read = FILENAME_LEN;
 
+    if (buf == NULL || nbytes < 0) {
+        return -1;
+    }
     // check if we've read all files
-    if (dentry_counter >= boot_block->dir_count) {
-        dentry_counter = 0;
+    if (read_dentry_by_index(file->file_pos, &dentry) == -1) {
         return 0;
     }
-
-    // get dentry of current file
-    dentry_t dentry = boot_block->direntries[pcb->file_descriptors[fd].file_pos];
-    read_dentry_by_index(dentry_counter, &dentry);
-    for (j = 0; j < FILENAME_LEN; j++) {
-        buffer[num_read] = dentry.filename[j]; // copy character in filename into main buffer
-        num_read++;
+    if (num_read > (uint32_t) nbytes) {
+        num_read = nbytes;
     }
-    dentry_counter++;
+    memcpy(buf, dentry.filename, num_read);
+    file->file_pos++;
     return num_read;
 }
 
+/* void stat_dentry(const dentry_t* dentry, stat_t* buf)
+ * Inputs:  const dentry_t* dentry: directory entry of the file,
+ *          stat_t* buf: loaded with the file's type, inode number and length
+ * Return Value: none
+ * Function: reads a file's metadata out of its dentry and inode without touching its data
+ */
+void stat_dentry(const dentry_t* dentry, stat_t* buf) {
+    buf->filetype = dentry->filetype;
+    buf->inode_num = 0;
+    buf->length = 0;
+    // the RTC and the directory have no inode of their own
+    if (dentry->filetype == REGULAR_FILE && dentry->inode_num < boot_block->inode_count) {
+        buf->inode_num = dentry->inode_num;
+        buf->length = get_inode(dentry->inode_num)->length;
+    }
+}
+
+/* int32_t getdents_directory(int32_t fd, dirent_t* buf, int32_t nbytes)
+ * Inputs:  int32_t fd: file descriptor array index of an open directory,
+ *          dirent_t* buf: filled in with one record per directory entry,
+ *          int32_t nbytes: size of buf in bytes
+ * Return Value: number of bytes filled in, a multiple of sizeof(dirent_t); 0 once every entry has been read
+ * Function: reads as many directory entries as fit in buf, from the same cursor as read_directory
+ */
+int32_t getdents_directory(int32_t fd, dirent_t* buf, int32_t nbytes) {
+    pcb_t *pcb = get_pcb(curr_pid);
+    fd_t *file = &pcb->file_descriptors[fd];
+    dentry_t dentry;
+    stat_t info;
+    uint32_t count = 0;
+
+    while ((count + 1) * sizeof(dirent_t) <= (uint32_t) nbytes && read_dentry_by_index(file->file_pos, &dentry) == 0) {
+        memcpy(buf[count].filename, dentry.filename, FILENAME_LEN);
+        stat_dentry(&dentry, &info);
+        buf[count].filetype = info.filetype;
+        buf[count].inode_num = dentry.inode_num;
+        buf[count].length = info.length;
+        count++;
+        file->file_pos++;
+    }
+    return count * sizeof(dirent_t);
+}
+
 
 
 /* int32_t write_directory(int32_t fd, const void* buf, int32_t nbytes)
@@ -13,6 +13,29 @@
 #define BYTES_PER_BLOCK 4096
 #define FILE_DESCRIPTOR_MAX 8
 #define FILE_DESCRIPTOR_MIN 2
+#define DENTRY_HASH_SIZE 128 /* power of two, at least twice DIR_ENTRIES to keep probe chains short */
+#define DENTRY_HASH_EMPTY 0xFF
+#define FNV_OFFSET_BASIS 0x811C9DC5
+#define FNV_PRIME 0x01000193
+#define FS_MAX_INODES 1024 /* inodes the free-inode bitmap covers */
+#define FS_MAX_DATA_BLOCKS 8192 /* data blocks the free-block bitmap covers */
+#define FS_WORD_BITS 32
+#define MAX_FILE_BLOCKS (ONE_KB-1) /* data block numbers an inode holds */
+#define RTC_FILE 0 /* dentry filetypes, and what stat reports */
+#define DIRECTORY_FILE 1
+#define REGULAR_FILE 2
+#define TERMINAL_FILE 3 /* only fstat reports these two */
+#define PIPE_FILE 4
+#define SEEK_SET 0 /* lseek whence: from the start, */
+#define SEEK_CUR 1 /* from the file position, */
+#define SEEK_END 2 /* or from the end of the file */
+#define FILE_POS_MAX 0x7FFFFFFF /* file_pos is signed */
+#define READ_AHEAD_BLOCKS 8 /* most data blocks a file cursor resolves ahead of a sequential reader */
+#define FS_EXTENT_MAGIC 0x31545845 /* "EXT1" at the start of the boot block's reserved bytes: inodes hold extents */
+#define INODE_EXTENTS 510 /* extents that fit in an extent inode */
+#define INDIRECT_EXTENTS (BYTES_PER_BLOCK / 8) /* extents that fit in an inode's indirect data block */
+#define MAX_EXTENTS (INODE_EXTENTS + INDIRECT_EXTENTS)
+#define EXTENT_MAX_FILE_BYTES 0xFFFFF000 /* largest length a 32-bit file position can reach block by block */
 
 
 
@@ -31,29 +54,76 @@ typedef struct inode {
     uint32_t data_block_num[ONE_KB-1];
 } inode_t;
 
+/* One directory entry as getdents returns it */
+typedef struct dirent {
+    uint8_t filename[FILENAME_LEN]; // null terminated only when shorter than FILENAME_LEN, like dentry_t
+    uint32_t filetype;
+    uint32_t inode_num;
+    uint32_t length; // in bytes, 0 for anything but a regular file
+} dirent_t;
+
+/* What stat and fstat return */
+typedef struct stat {
+    uint32_t filetype; // RTC_FILE through PIPE_FILE
+    uint32_t inode_num; // regular files only, 0 otherwise
+    uint32_t length; // bytes in a regular file or waiting in a pipe, 0 otherwise
+} stat_t;
+
+/* A run of data blocks that follow each other in the image */
+typedef struct extent {
+    uint32_t start; // first data block number
+    uint32_t length; // in data blocks
+} extent_t;
+
+/* inode of an extent format image. The file's blocks are its extents in order; extents past INODE_EXTENTS
+ * live in indirect_block, a data block of extent_t. */
+typedef struct extent_inode {
+    uint32_t length;
+    uint32_t num_extents;
+    uint32_t indirect_block; // only meaningful once num_extents > INODE_EXTENTS
+    extent_t extents[INODE_EXTENTS];
+} extent_inode_t;
+
 /* inode structure from slides*/
 typedef struct boot_block {
     uint32_t dir_count;
     uint32_t inode_count;
     uint32_t data_count;
-    uint8_t reserved[BOOT_BLOCK_RESERVED_BYTES];
+    uint8_t reserved[BOOT_BLOCK_RESERVED_BYTES]; // an extent format image starts these with FS_EXTENT_MAGIC
     dentry_t direntries[DIR_ENTRIES];
 } boot_block_t;
 
 // function declarations
 void init_file_sys(uint32_t starting_addr);
+uint32_t dentry_name_hash(const uint8_t* name, uint32_t* name_len);
+void build_dentry_hash();
 int32_t read_dentry_by_name (const uint8_t* fname, dentry_t* dentry);
 int32_t read_dentry_by_index (uint32_t index, dentry_t* dentry);
 int32_t read_data (uint32_t inode, uint32_t offset, uint8_t* buf, uint32_t length);
+uint8_t* file_block_addr(uint32_t inode_num, uint32_t offset);
+
+/* 1 when the image's inodes are extent_inode_t, 0 for the flat inode_t format */
+extern uint32_t extent_fs;
+
+/* Free inodes and data blocks left in the image */
+extern uint32_t fs_free_inode_count;
+extern uint32_t fs_free_block_count;
+
+int32_t fs_create(const uint8_t* fname);
+int32_t fs_unlink(const uint8_t* fname);
 
 int32_t read_file(int32_t fd, void* buf, int32_t nbytes);
 int32_t write_file(int32_t fd, const void* buf, int32_t nbytes);
 int32_t open_file(const uint8_t* filename);
 int32_t close_file(int32_t fd);
+int32_t lseek_file(int32_t fd, int32_t offset, int32_t whence);
+int32_t pread_file(int32_t fd, void* buf, int32_t nbytes, int32_t offset);
 
 int32_t read_directory(int32_t fd, void* buf, int32_t nbytes);
 int32_t write_directory(int32_t fd, const void* buf, int32_t nbytes);
 int32_t open_directory(const uint8_t* filename);
 int32_t close_directory(int32_t fd);
+int32_t getdents_directory(int32_t fd, dirent_t* buf, int32_t nbytes);
+void stat_dentry(const dentry_t* dentry, stat_t* buf);
 
 #endif
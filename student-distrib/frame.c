@@ -0,0 +1,141 @@
+/* Physical frame allocator. One bit per 4 kB frame, set while the frame is free. */
+
+#include "frame.h"
+#include "lib.h"
+
+static uint32_t frame_bitmap[NUM_FRAMES / FRAME_WORD_BITS];
+static uint8_t frame_ref_count[NUM_FRAMES]; // page tables mapping each allocated frame, at most NUM_PROCESSES
+uint32_t free_frame_count = 0;
+
+/* Bitmap word to start searching from. Every word before it is known to be empty. */
+static uint32_t first_free_word = 0;
+
+/* 
+ * init_frames
+ *   DESCRIPTION: Marks every frame as in use. Memory only becomes allocatable once the multiboot
+ *                memory map says it is there.
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: none
+ */
+void init_frames() {
+    memset(frame_bitmap, 0, sizeof(frame_bitmap));
+    free_frame_count = 0;
+    first_free_word = NUM_FRAMES / FRAME_WORD_BITS;
+}
+
+/* 
+ * add_free_memory
+ *   DESCRIPTION: Frees every whole frame of a region that lies between FRAME_ALLOC_START and FRAME_ALLOC_END.
+ *   INPUTS: base_addr -- physical start of the region
+ *           length -- size of the region in bytes
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: none
+ */
+void add_free_memory(uint32_t base_addr, uint32_t length) {
+    uint32_t start = (base_addr + FRAME_SIZE - 1) >> FRAME_SHIFT;
+    uint32_t end = (base_addr + length) >> FRAME_SHIFT;
+    uint32_t frame;
+
+    // regions that run past 4 GB get cut off at the top of the bitmap
+    if (base_addr + length < base_addr || end > NUM_FRAMES) {
+        end = NUM_FRAMES;
+    }
+    if (start < (FRAME_ALLOC_START >> FRAME_SHIFT)) {
+        start = FRAME_ALLOC_START >> FRAME_SHIFT;
+    }
+
+    for (frame = start; frame < end; frame++) {
+        free_frame(frame << FRAME_SHIFT);
+    }
+}
+
+/* 
+ * alloc_frame
+ *   DESCRIPTION: Finds a free frame a word of the bitmap at a time and marks it used.
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: physical address of the frame, NO_FRAME if none are left
+ *   SIDE EFFECTS: The frame's contents are whatever was there before. Call with interrupts off.
+ */
+uint32_t alloc_frame() {
+    uint32_t word;
+    uint32_t bit;
+
+    for (word = first_free_word; word < NUM_FRAMES / FRAME_WORD_BITS; word++) {
+        if (frame_bitmap[word] != 0) {
+            asm volatile("bsfl %1, %0" : "=r" (bit) : "r" (frame_bitmap[word]));
+            frame_bitmap[word] &= ~(1 << bit);
+            frame_ref_count[word * FRAME_WORD_BITS + bit] = 1;
+            free_frame_count--;
+            first_free_word = word;
+            return (word * FRAME_WORD_BITS + bit) << FRAME_SHIFT;
+        }
+    }
+    first_free_word = NUM_FRAMES / FRAME_WORD_BITS;
+    return NO_FRAME;
+}
+
+/* 
+ * free_frame
+ *   DESCRIPTION: Drops a reference to a frame and marks it free again once the last one is gone.
+ *   INPUTS: addr -- physical address of the frame
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: Ignores addresses outside the allocatable range and frames that are already free.
+ *                 Call with interrupts off.
+ */
+void free_frame(uint32_t addr) {
+    uint32_t frame = addr >> FRAME_SHIFT;
+    uint32_t word = frame / FRAME_WORD_BITS;
+    uint32_t mask = 1 << (frame % FRAME_WORD_BITS);
+
+    if (addr < FRAME_ALLOC_START || frame >= NUM_FRAMES || (frame_bitmap[word] & mask)) {
+        return;
+    }
+    if (frame_ref_count[frame] > 1) {
+        frame_ref_count[frame]--;
+        return;
+    }
+    frame_ref_count[frame] = 0;
+    frame_bitmap[word] |= mask;
+    free_frame_count++;
+    if (word < first_free_word) {
+        first_free_word = word;
+    }
+}
+
+/* 
+ * ref_frame
+ *   DESCRIPTION: Counts one more page table mapping an allocated frame.
+ *   INPUTS: addr -- physical address of the frame
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: Ignores frames the allocator doesn't manage. Call with interrupts off.
+ */
+void ref_frame(uint32_t addr) {
+    uint32_t frame = addr >> FRAME_SHIFT;
+
+    if (addr >= FRAME_ALLOC_START && frame < NUM_FRAMES && frame_ref_count[frame] != 0) {
+        frame_ref_count[frame]++;
+    }
+}
+
+/* 
+ * frame_refs
+ *   DESCRIPTION: Tells how many page tables map a frame.
+ *   INPUTS: addr -- physical address of the frame
+ *   OUTPUTS: none
+ *   RETURN VALUE: reference count, 0 for free frames and frames the allocator doesn't manage
+ *   SIDE EFFECTS: none
+ */
+uint32_t frame_refs(uint32_t addr) {
+    uint32_t frame = addr >> FRAME_SHIFT;
+
+    if (addr < FRAME_ALLOC_START || frame >= NUM_FRAMES) {
+        return 0;
+    }
+    return frame_ref_count[frame];
+}
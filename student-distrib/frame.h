@@ -0,0 +1,35 @@
+#ifndef _FRAME_H_
+#define _FRAME_H_
+
+#include "types.h"
+
+#define FRAME_SIZE          0x1000      /* 4 kB physical frames */
+#define FRAME_SHIFT         12
+#define FRAME_ALLOC_START   0x800000    /* everything below 8 MB belongs to the kernel and the kernel stacks */
+#define FRAME_ALLOC_END     0x40000000  /* the bitmap covers the first 1 GB of physical memory */
+#define NUM_FRAMES          (FRAME_ALLOC_END / FRAME_SIZE)
+#define FRAME_WORD_BITS     32
+#define NO_FRAME            0           /* never handed out, it's below FRAME_ALLOC_START */
+
+/* Number of frames that are free right now */
+extern uint32_t free_frame_count;
+
+/* Marks every frame as in use, call before add_free_memory */
+void init_frames();
+
+/* Makes the frames of an available region from the multiboot memory map allocatable */
+void add_free_memory(uint32_t base_addr, uint32_t length);
+
+/* Takes a free frame with one reference, returns its physical address or NO_FRAME if memory is full */
+uint32_t alloc_frame();
+
+/* Drops a reference to a frame, it is free once nobody maps it */
+void free_frame(uint32_t addr);
+
+/* Adds a reference to a frame that another page table now maps too (fork) */
+void ref_frame(uint32_t addr);
+
+/* Number of page tables mapping a frame */
+uint32_t frame_refs(uint32_t addr);
+
+#endif
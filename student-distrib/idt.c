@@ -63,7 +63,7 @@ void build_idt() {
     SET_IDT_ENTRY(idt[SEGMENT_NOT_PRESENT], segment_not_present);
     SET_IDT_ENTRY(idt[STACK_FAULT], stack_fault);
     SET_IDT_ENTRY(idt[GENERAL_PROTECTION], general_protection);
-    SET_IDT_ENTRY(idt[PAGE_FAULT], page_fault);
+    SET_IDT_ENTRY(idt[PAGE_FAULT], page_fault_linkage);
     SET_IDT_ENTRY(idt[x87_FP_ERROR], x87_fp_error);
     SET_IDT_ENTRY(idt[ALIGNMENT_CHECK], alignment_check);
     SET_IDT_ENTRY(idt[MACHINE_CHECK], machine_check);
@@ -79,6 +79,8 @@ void build_idt() {
     idt[KEYBOARD].present = 1;
     idt[PIT].reserved3 = 0; // Need to change to interrupt gate. See ISA manual page 156.
     idt[PIT].present = 1;
+    // Page faults load user pages, nothing may run before CR2 is read
+    idt[PAGE_FAULT].reserved3 = 0;
     // Sets each interrupt with corresponding function pointer
     SET_IDT_ENTRY(idt[KEYBOARD], keyboard_handler_linkage);
     SET_IDT_ENTRY(idt[RTC], rtc_handler_linkage);
@@ -226,12 +228,21 @@ void general_protection() {
 }
 
 /* page_fault()
- * Inputs: none
+ * Inputs: error_code: pushed by the CPU, see PF_PRESENT etc.
  * Return Value: none
- * Function: Prints exception message and sends to infinite loop.
+ * Function: Loads user pages that haven't been touched yet and copies
+ * copy-on-write pages on the first write. Any other fault
+ * prints exception message and halts the process.
  */
-void page_fault() {
+void page_fault(uint32_t error_code) {
     uint32_t location = page_fault_location();
+
+    if (!(error_code & PF_PRESENT) && demand_page(location) == 0) {
+        return;
+    }
+    if ((error_code & PF_PRESENT) && (error_code & PF_WRITE) && copy_on_write(location) == 0) {
+        return;
+    }
     printf("Page-Fault Exception: %x \n", location);
     system_halt((uint8_t) EXCEPTION);
 }
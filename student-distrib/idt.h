@@ -37,6 +37,11 @@
 #define MACHINE_CHECK   18
 #define SIMD_FP_ERROR   19
 
+/* Page fault error code bits */
+#define PF_PRESENT      0x1     /* set: protection violation, clear: page not present */
+#define PF_WRITE        0x2
+#define PF_USER         0x4
+
 /* Initialize the idt */
 void idt_init();
 
@@ -58,7 +63,7 @@ void invalid_tss();
 void segment_not_present(); 
 void stack_fault(); 
 void general_protection();
-void page_fault();
+void page_fault(uint32_t error_code);
 void x87_fp_error();
 void alignment_check();
 void machine_check();
@@ -68,6 +73,7 @@ void simd_fp_error();
 // void system_call();
 
 extern uint32_t page_fault_location();
+extern void page_fault_linkage();
 
 #endif /* IDT_H */
 
@@ -24,6 +24,9 @@
 
 //MP 3.5: Added headers
 #include "pit.h"
+#include "sched.h"
+#include "frame.h"
+#include "pipe.h"
 
 // #define RUN_TESTS
 
@@ -40,7 +43,6 @@ void entry(unsigned long magic, unsigned long addr) {
     multiboot_info_t *mbi;
 
     /* Clear the screen. */
-    DISPLAY_ON_MAIN_PAGE = 0;
     clear();
 
     /* Am I booted by a Multiboot-compliant boot loader? */
@@ -55,9 +57,16 @@ void entry(unsigned long magic, unsigned long addr) {
     /* Print out the flags. */
     printf("flags = 0x%#x\n", (unsigned)mbi->flags);
 
+    /* No physical frames can be allocated until the memory map says where RAM is. */
+    init_frames();
+
     /* Are mem_* valid? */
-    if (CHECK_FLAG(mbi->flags, 0))
+    if (CHECK_FLAG(mbi->flags, 0)) {
         printf("mem_lower = %uKB, mem_upper = %uKB\n", (unsigned)mbi->mem_lower, (unsigned)mbi->mem_upper);
+        /* Without a memory map, trust that upper memory is one block starting at 1 MB. */
+        if (!CHECK_FLAG(mbi->flags, 6))
+            add_free_memory(0x100000, mbi->mem_upper * 1024);
+    }
 
     /* Is boot_device valid? */
     if (CHECK_FLAG(mbi->flags, 1))
@@ -105,7 +114,7 @@ void entry(unsigned long magic, unsigned long addr) {
                 (unsigned)mbi->mmap_addr, (unsigned)mbi->mmap_length);
         for (mmap = (memory_map_t *)mbi->mmap_addr;
                 (unsigned long)mmap < mbi->mmap_addr + mbi->mmap_length;
-                mmap = (memory_map_t *)((unsigned long)mmap + mmap->size + sizeof (mmap->size)))
+                mmap = (memory_map_t *)((unsigned long)mmap + mmap->size + sizeof (mmap->size))) {
             printf("    size = 0x%x, base_addr = 0x%#x%#x\n    type = 0x%x,  length    = 0x%#x%#x\n",
                     (unsigned)mmap->size,
                     (unsigned)mmap->base_addr_high,
@@ -113,6 +122,11 @@ void entry(unsigned long magic, unsigned long addr) {
                     (unsigned)mmap->type,
                     (unsigned)mmap->length_high,
                     (unsigned)mmap->length_low);
+            /* Type 1 is usable RAM. Anything above 4 GB is out of reach. */
+            if (mmap->type == 1 && mmap->base_addr_high == 0)
+                add_free_memory(mmap->base_addr_low, mmap->length_high ? -mmap->base_addr_low : mmap->length_low);
+        }
+        printf("free frames = %u\n", free_frame_count);
     }
 
     /* Construct an LDT entry in the GDT */
@@ -177,9 +191,11 @@ void entry(unsigned long magic, unsigned long addr) {
     /* Init the page*/
     init_page();
 
+    /* Init the run queue. */
+    init_sched();
+
     /* Initializes the PIT. */
     init_pit();
-    DISPLAY_ON_MAIN_PAGE = 0;
 
     /* Init file system. */
     init_file_sys(fs);
@@ -187,6 +203,9 @@ void entry(unsigned long magic, unsigned long addr) {
     /* Init the file operations table. */
     init_fops_table();
 
+    /* Init the pipe table. */
+    init_pipes();
+
     /* Enable interrupts */
     /* Do not enable the following until after you have set up your
      * IDT correctly otherwise QEMU will triple fault and simple close
@@ -199,8 +218,9 @@ void entry(unsigned long magic, unsigned long addr) {
     // /* Run tests */
     // launch_tests();
 #endif
-    /* Execute the first program ("shell") ... */
-    system_execute((uint8_t *) "shell");
+    /* Spawn the first program ("shell") and switch to it ... */
+    system_spawn((uint8_t *) "shell");
+    scheduler();
     /* Spin (nicely, so we don't chew up cycles) */
     asm volatile (".1: hlt; jmp .1;");
 }
@@ -2,7 +2,6 @@
 #include "terminal.h"
 #include "pit.h"
 #include "syscalls.h"
-#include "page.h"
 
 /* Global variables for handling keyboard */
 static int shift_held = 0;
@@ -10,9 +9,7 @@ static int caps_locked_activated = 0;
 static int caps_lock_held = 0;
 static int ctrl_held = 0;
 static int alt_held = 0;
-
-/* Terminal Flag used for move_cursor. */
-extern int terminal_flag;
+static int extended_key = 0;
 
 /* 
  * init_ps2devices
@@ -25,7 +22,6 @@ extern int terminal_flag;
 void init_ps2devices() {
     /* Enable IRQ 1 in the PIC*/
     enable_irq(KEYBOARD_IRQ);
-    DISPLAY_ON_MAIN_PAGE = 0;
 }
 
 /* 
@@ -42,7 +38,19 @@ void keyboard_handler() {
     /* Gets the data from the keyboard.*/
     response = inb(PS2_DATA_PORT);
 
+    /* Extended keys we don't handle share their scan codes with the keys they duplicate, like right CTRL. */
+    if (extended_key) {
+        extended_key = 0;
+        if (extended_key_handler(response)) {
+            send_eoi(KEYBOARD_IRQ);
+            return;
+        }
+    }
+
     switch(response){
+        case EXTENDED_PREFIX:
+            extended_key = 1;
+            break;
         case CAPS_LOCK_PRESSED:
             caps_lock_handler(CAPS_LOCK_PRESSED);
             break;
@@ -156,6 +164,42 @@ void ctrl_key_handler(uint8_t response) {
     }
 }
 
+/* 
+ * extended_key_handler
+ *   DESCRIPTION: Takes care of the scan code after an extended prefix. SHIFT-PAGE UP and SHIFT-PAGE DOWN
+ *                move the screen terminal's view through its scrollback.
+ *   INPUTS: uint8_t response -- The scan code after the prefix.
+ *   OUTPUTS: none
+ *   RETURN VALUE: 1 if the key was handled here, 0 if it should be handled like its unprefixed scan code.
+ *   SIDE EFFECTS: May scroll the screen terminal's view.
+ *                 
+ */
+int extended_key_handler(uint8_t response) {
+    switch(response){
+        case PAGE_UP_PRESSED:
+            if (shift_held) {
+                scroll_view(screen_terminal, SCROLLBACK_PAGE);
+            }
+            return 1;
+        case PAGE_DOWN_PRESSED:
+            if (shift_held) {
+                scroll_view(screen_terminal, -SCROLLBACK_PAGE);
+            }
+            return 1;
+        case PAGE_UP_RELEASED:
+        case PAGE_DOWN_RELEASED:
+            return 1;
+        /* The keyboard wraps the gray keys in fake SHIFT presses and releases, they aren't the user's. */
+        case LEFT_SHIFT_PRESSED:
+        case LEFT_SHIFT_RELEASED:
+        case RIGHT_SHIFT_PRESSED:
+        case RIGHT_SHIFT_RELEASED:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
 /* 
  * alt_key_handler
  *   DESCRIPTION: Takes care of the ALT key.
@@ -358,21 +402,16 @@ uint8_t shift_and_caps_data(uint8_t response) {
 
 /* 
  * switch_screen
- *   DESCRIPTION: Remaps video memory corresponding to the terminal that the user wants to switch to, and saves our old video memory into a backup page.
+ *   DESCRIPTION: Shows the terminal that the user wants to switch to. Every terminal keeps drawing into its own
+ *                page of text memory, so only the VGA start address changes.
  *   INPUTS: uint8_t new_terminal - The terminal that the user wants to switch to.
  *   OUTPUTS: none
  *   RETURN VALUE: None
- *   SIDE EFFECTS: Remaps video memory corresponding the terminal that the user wants to switch to, and repositions the cursor.
+ *   SIDE EFFECTS: Changes screen_terminal and repositions the cursor.
  *                 
  */
 void switch_screen(uint8_t new_terminal) {
     cli();
-    memcpy((char *) VIDEO_ADDR + ((screen_terminal+1) * ALIGN), (char *) VIDEO_ADDR , FOUR_KB); // save current screen mem values to backup terminal video page
-    vid_map[0].base_addr = (int) (VIDEO_ADDR / ALIGN) + (screen_terminal+1); // switch user vid map to point to backup terminal page
-    flushTLB();
-    memcpy((char *) VIDEO_ADDR, (char *) VIDEO_ADDR + ((new_terminal+1) * ALIGN), FOUR_KB); // save backup terminal video page to  current screen mem values
-    terminal_flag = 0;
-    screen_terminal = new_terminal;
-    move_cursor();
+    display_terminal(new_terminal);
     sti();
 }
@@ -41,6 +41,13 @@
 #define ENTER_PRESESED 0x1C
 #define TAB_PRESSED 0x0F
 
+#define EXTENDED_PREFIX 0xE0 /* the next scan code is a key only the extended keyboard has */
+#define PAGE_UP_PRESSED 0x49
+#define PAGE_UP_RELEASED 0xC9
+#define PAGE_DOWN_PRESSED 0x51
+#define PAGE_DOWN_RELEASED 0xD1
+#define SCROLLBACK_PAGE 24 /* rows SHIFT-PAGE UP/DOWN scroll, a screen less one row of overlap */
+
 #define F1_PRESSED 0xBB
 #define F2_PRESSED 0xBC
 #define F3_PRESSED 0xBD
@@ -92,6 +99,9 @@ void enter_key_handler();
 /* Takes care of TAB key. */
 void tab_key_handler();
 
+/* Takes care of keys sent after the extended prefix. */
+int extended_key_handler(uint8_t response);
+
 /* Takes care of the ALT key. */
 void alt_key_handler(uint8_t response);
 
@@ -6,55 +6,124 @@
 #include "keyboard.h"
 #include "syscalls.h"
 
-#define VIDEO       0xB8000
-#define NUM_COLS    80
-#define NUM_ROWS    25
 #define CURSOR_LOC_HIGH_REG 0x0E
 #define CURSOR_LOC_LOW_REG 0x0F
 #define GET_8_MSB 8
 #define GET_8_BITS 0xFF
 #define CRTC_ADDR_PORT 0x3D4
 #define CRTC_DATA_PORT 0x3D5
-
-static char* video_mem = (char *)VIDEO;
+#define CRTC_START_HIGH_REG 0x0C
+#define CRTC_START_LOW_REG 0x0D
+#define PAGE_CELLS 2048 /* cells in each terminal's 4 kB page of text memory */
+#define TERMINAL_PAGE(term) ((char *) VIDEO + ((term) << 12)) /* every terminal is always drawn into its own page */
+#define ROW_BYTES (NUM_COLS << 1) /* a character byte and an attribute byte per cell */
+#define BLANK_CELLS(attrib) ((((attrib) << 8) | ' ') * 0x10001) /* two blank cells, for memset_dword */
+#define SCROLLBACK_ROWS 2048 /* rows kept per terminal, a power of two so ring indices wrap with a mask */
+#define RING_ROW(term, n) (history[(term)][(n) & (SCROLLBACK_ROWS - 1)])
+#define SCREEN_ROW(term, y) RING_ROW(term, top_row[(term)] + (y)) /* row y of what the terminal's program sees */
+#define ALL_ROWS_DIRTY ((1 << NUM_ROWS) - 1)
 
 int ATTRIB = 0x7;
 
-// indicates which terminal to operate on, screen terminal (0) or current terminal (1) operated on by scheduler (may or may not be the same)
-int terminal_flag = 0; 
+/* What each terminal's console holds: a ring of rows whose last NUM_ROWS rows are the screen and the rest
+ * is scrollback. putc and friends only write here, console_flush copies the rows that changed to the
+ * terminal's page of text memory. */
+static uint16_t history[MAX_TERMINALS][SCROLLBACK_ROWS][NUM_COLS];
+
+/* Ring index of each terminal's top screen row. It only ever counts up and is masked when used. */
+static uint32_t top_row[MAX_TERMINALS];
+
+/* Rows above the screen that hold scrolled off output. */
+static int32_t history_rows[MAX_TERMINALS];
+
+/* How many rows back into the scrollback each terminal is showing, 0 for the live screen. */
+static int32_t view_back[MAX_TERMINALS];
+
+/* Processes that drew on each terminal's page of text memory through vidmap and haven't halted. While
+ * there are any, the page is theirs and console_flush leaves it alone. */
+static int32_t vidmap_users[MAX_TERMINALS];
+
+/* Bit n is set when row n of a terminal's screen is newer than its text memory. */
+static uint32_t dirty_rows[MAX_TERMINALS];
+
+/* Set when the cursor moved since the last flush. */
+static int32_t cursor_moved = 0;
+
+/* static void console_written(void);
+ * Inputs: none
+ * Return Value: none
+ * Function: Called after every change to a console. Until the first process runs there is no PIT tick
+ *           to flush it, so the kernel's own output goes to the screen right away. */
+static void console_written(void) {
+    if (curr_pid == NO_PID) {
+        console_flush();
+    }
+}
+
+/* static void scroll_up(int32_t term);
+ * Inputs: int32_t term = terminal to scroll
+ * Return Value: none
+ * Function: Moves the screen down the ring one row, so the top row becomes scrollback without being copied,
+ *           and blanks the new bottom row, which reuses the oldest row of scrollback. A terminal that is
+ *           showing scrollback keeps showing the same rows. */
+static void scroll_up(int32_t term) {
+    top_row[term]++;
+    memset_dword(SCREEN_ROW(term, NUM_ROWS - 1), BLANK_CELLS(terminal_array[term].attribute), NUM_COLS / 2);
+    if (history_rows[term] < SCROLLBACK_ROWS - NUM_ROWS) {
+        history_rows[term]++;
+    }
+    if (view_back[term] && view_back[term] < history_rows[term]) {
+        view_back[term]++;
+    }
+    dirty_rows[term] = ALL_ROWS_DIRTY;
+}
+
+/* static void copy_rows(int32_t term, int32_t row, int32_t end);
+ * Inputs: int32_t term = terminal to draw
+ *         int32_t row = first screen row to copy
+ *         int32_t end = screen row after the last one to copy
+ * Return Value: none
+ * Function: Copies the rows the terminal is showing from its ring to its page of text memory. The rows are
+ *           contiguous in the ring unless they wrap past its end, so this is one copy, or two when they do. */
+static void copy_rows(int32_t term, int32_t row, int32_t end) {
+    uint32_t first = (top_row[term] - view_back[term] + row) & (SCROLLBACK_ROWS - 1);
+    int32_t rows = end - row;
+    int32_t before_wrap = SCROLLBACK_ROWS - first;
+
+    if (rows <= before_wrap) {
+        memcpy(TERMINAL_PAGE(term) + row * ROW_BYTES, history[term][first], rows * ROW_BYTES);
+        return;
+    }
+    memcpy(TERMINAL_PAGE(term) + row * ROW_BYTES, history[term][first], before_wrap * ROW_BYTES);
+    memcpy(TERMINAL_PAGE(term) + (row + before_wrap) * ROW_BYTES, history[term][0], (rows - before_wrap) * ROW_BYTES);
+}
 
 /* void clear(void);
  * Inputs: void
  * Return Value: none
- * Function: Clears video memory on a specific terminal. */
+ * Function: Clears the terminal of the process that is running. */
 void clear(void) {
-    int32_t i;
-    uint8_t ATTRIB;
-    char *true_mem = video_mem;
-
-    /* Checking if the terminal screen that we are editing is not currently on the screen. */
-    if(curr_terminal != screen_terminal && (DISPLAY_ON_MAIN_PAGE == 0)) {
-        true_mem = (char *) VIDEO_ADDR + ((curr_terminal+1) << 12);
-        terminal_array[curr_terminal].screen_x=0;
-        terminal_array[curr_terminal].screen_y=0;
-        terminal_flag = 1;
-        ATTRIB = terminal_array[curr_terminal].attribute;
-    }
-    /* Case where the screen that is being cleared is currently is on the screen. */
-    else {
-        DISPLAY_ON_MAIN_PAGE = 0; //setting flag back to zero, it's keyboard handlers jobs to let libc know each time
-        terminal_array[screen_terminal].screen_x=0;
-        terminal_array[screen_terminal].screen_y=0;
-        ATTRIB = terminal_array[screen_terminal].attribute;
-        terminal_flag = 0;
-    }
+    term_clear(curr_terminal);
+}
+
+/* void term_clear(int32_t term);
+ * Inputs: int32_t term = terminal to clear
+ * Return Value: none
+ * Function: Clears video memory on a specific terminal. */
+void term_clear(int32_t term) {
+    int32_t row;
+
+    terminal_array[term].screen_x = 0;
+    terminal_array[term].screen_y = 0;
 
-    /* Set the whole screen to empty.*/
-    for (i = 0; i < NUM_ROWS * NUM_COLS; i++) {
-        *(uint8_t *)(true_mem + (i << 1)) = ' ';
-        *(uint8_t *)(true_mem + (i << 1) + 1) = ATTRIB;
+    /* Set the whole screen to empty, two cells per store. The scrollback is kept. */
+    for (row = 0; row < NUM_ROWS; row++) {
+        memset_dword(SCREEN_ROW(term, row), BLANK_CELLS(terminal_array[term].attribute), NUM_COLS / 2);
     }
+    view_back[term] = 0;
+    dirty_rows[term] = ALL_ROWS_DIRTY;
     move_cursor();
+    console_written();
 }
 
 /* Standard printf().
@@ -199,60 +268,93 @@ int32_t puts(int8_t* s) {
 /* void putc(uint8_t c);
  * Inputs: uint_8* c = character to print
  * Return Value: void
- *  Function: Output a character to the respective console */
+ *  Function: Output a character to the console of the process that is running */
 void putc(uint8_t c) {
-    int i, j;
-    uint8_t ATTRIB;
-    uint8_t character;
-    char *true_mem = video_mem;
-    int true_term_id = screen_terminal;
-
-    /* Check if the terminal that we want to edit is currently on screen. */
-    if(curr_terminal != screen_terminal && (DISPLAY_ON_MAIN_PAGE == 0)) {
-        true_mem = (char *) VIDEO_ADDR + ((curr_terminal+1) << 12);
-        true_term_id = curr_terminal;
-        terminal_flag = 1;
-        ATTRIB = terminal_array[curr_terminal].attribute;
-    }
-    /* Case where the terminal we are trying to edit is on screen. */
-    else {
-        DISPLAY_ON_MAIN_PAGE = 0; //setting flag back to zero, it's keyboard handlers jobs to let libc know each time
-        terminal_flag = 0;
-        ATTRIB = terminal_array[screen_terminal].attribute;
-    }
+    term_putc(curr_terminal, c);
+}
+
+/* void term_putc(int32_t term, uint8_t c);
+ * Inputs: int32_t term = terminal to print on
+ *         uint_8* c = character to print
+ * Return Value: void
+ *  Function: Output a character to a terminal's console, whether or not it is on screen */
+void term_putc(int32_t term, uint8_t c) {
+    uint8_t ATTRIB = terminal_array[term].attribute;
 
     if(c == '\n' || c == '\r') {
-        terminal_array[true_term_id].screen_y++;
-        terminal_array[true_term_id].screen_x = 0;
+        terminal_array[term].screen_y++;
+        terminal_array[term].screen_x = 0;
     } 
     else {
-        *(uint8_t *)(true_mem + ((NUM_COLS * terminal_array[true_term_id].screen_y + terminal_array[true_term_id].screen_x) << 1)) = c;
-        *(uint8_t *)(true_mem + ((NUM_COLS * terminal_array[true_term_id].screen_y + terminal_array[true_term_id].screen_x) << 1) + 1) = ATTRIB;
-        terminal_array[true_term_id].screen_x++;
-        check_size(); /* Checks if we went out of bounds. */
+        SCREEN_ROW(term, terminal_array[term].screen_y)[terminal_array[term].screen_x] = (ATTRIB << 8) | c;
+        dirty_rows[term] |= 1 << terminal_array[term].screen_y;
+        terminal_array[term].screen_x++;
+        check_size(term); /* Checks if we went out of bounds. */
     }
 
     /* Checks if the y position exceeds the window. If so, scroll up and reposition the cursor.*/
-    if (terminal_array[true_term_id].screen_y > NUM_ROWS-1){
-        for (i = 0; i < NUM_ROWS-1; i++){
-            for (j = 0; j < NUM_COLS; j++){
-                /* For each iteration, replace the top row with the row below it. */
-                character = *(uint8_t *)(true_mem + ((NUM_COLS * (i+1) + j) << 1));
-                *(uint8_t *)(true_mem + ((NUM_COLS * i + j) << 1)) = character;
-                *(uint8_t *)(true_mem + ((NUM_COLS * i + j) << 1) + 1) = ATTRIB;
+    if (terminal_array[term].screen_y > NUM_ROWS-1){
+        scroll_up(term);
+        terminal_array[term].screen_y = NUM_ROWS-1;
+        terminal_array[term].screen_x = 0;
+    }
+    move_cursor();
+    console_written();
+}
+
+/* int32_t putbuf(int32_t term_id, const uint8_t* buf, int32_t n);
+ * Inputs: int32_t term_id = terminal to print on
+ *         const uint8_t* buf = characters to print, NULs are skipped
+ *         int32_t n = number of bytes in buf
+ * Return Value: Number of bytes printed
+ * Function: Output a buffer to a terminal's console like term_putc does one character at a time, but
+ *           stores runs of characters straight into the cells. */
+int32_t putbuf(int32_t term_id, const uint8_t* buf, int32_t n) {
+    uint16_t* cells;
+    terminal_info_t* term = &terminal_array[term_id];
+    uint16_t attrib = term->attribute << 8;
+    int32_t i = 0;
+    int32_t printed = 0;
+    int32_t end;
+
+    while (i < n) {
+        if (buf[i] == '\0') {
+            i++;
+            continue;
+        }
+        if (buf[i] == '\n' || buf[i] == '\r') {
+            term->screen_y++;
+            term->screen_x = 0;
+            i++;
+            printed++;
+        }
+        else {
+            /* A run of characters up to the end of the row. */
+            dirty_rows[term_id] |= 1 << term->screen_y;
+            cells = SCREEN_ROW(term_id, term->screen_y);
+            end = i + NUM_COLS - term->screen_x;
+            if (end > n) {
+                end = n;
+            }
+            for (; i < end && buf[i] != '\0' && buf[i] != '\n' && buf[i] != '\r'; i++) {
+                cells[term->screen_x] = attrib | buf[i];
+                term->screen_x++;
+                printed++;
+            }
+            if (term->screen_x >= NUM_COLS) {
+                term->screen_y++;
+                term->screen_x = 0;
             }
         }
 
-        /* Separate case for printing the last row, since there is no row below it. */
-        i = NUM_ROWS-1;
-        for (j = 0; j < NUM_COLS; j++){
-            *(uint8_t *)(true_mem + ((NUM_COLS * (i) + j) << 1)) = 0x0;
-            *(uint8_t *)(true_mem + ((NUM_COLS * (i) + j) << 1) + 1) = ATTRIB;
+        if (term->screen_y > NUM_ROWS-1) {
+            scroll_up(term_id);
+            term->screen_y = NUM_ROWS-1;
         }
-        terminal_array[true_term_id].screen_y = NUM_ROWS-1;
-        terminal_array[true_term_id].screen_x = 0;
     }
     move_cursor();
+    console_written();
+    return printed;
 }
 
 /* int8_t* itoa(uint32_t value, int8_t* buf, int32_t radix);
@@ -369,7 +471,7 @@ void* memset(void* s, int32_t c, uint32_t n) {
  * Description: Optimized memset_word
  * Inputs:    void* s = pointer to memory
  *          int32_t c = value to set memory to
- *         uint32_t n = number of bytes to set
+ *         uint32_t n = number of words to set
  * Return Value: new string
  * Function: set lower 16 bits of n consecutive memory locations of pointer s to value c */
 void* memset_word(void* s, int32_t c, uint32_t n) {
@@ -389,7 +491,7 @@ void* memset_word(void* s, int32_t c, uint32_t n) {
 /* void* memset_dword(void* s, int32_t c, uint32_t n);
  * Inputs:    void* s = pointer to memory
  *          int32_t c = value to set memory to
- *         uint32_t n = number of bytes to set
+ *         uint32_t n = number of dwords to set
  * Return Value: new string
  * Function: set n consecutive memory locations of pointer s to value c */
 void* memset_dword(void* s, int32_t c, uint32_t n) {
@@ -452,7 +554,7 @@ void* memcpy(void* dest, const void* src, uint32_t n) {
 }
 
 /* void* memmove(void* dest, const void* src, uint32_t n);
- * Description: Optimized memmove (used for overlapping memory areas)
+ * Description: Optimized memmove (used for overlapping memory areas), a dword at a time when moving down
  * Inputs:      void* dest = destination of move
  *         const void* src = source of move
  *              uint32_t n = number of byets to move
@@ -464,12 +566,21 @@ void* memmove(void* dest, const void* src, uint32_t n) {
             movw    %%dx, %%es                  \n\
             cld                                 \n\
             cmp     %%edi, %%esi                \n\
-            jae     .memmove_go                 \n\
+            jb      .memmove_back               \n\
+            movl    %%ecx, %%edx                \n\
+            shrl    $2, %%ecx                   \n\
+            rep     movsl                       \n\
+            movl    %%edx, %%ecx                \n\
+            andl    $3, %%ecx                   \n\
+            rep     movsb                       \n\
+            jmp     .memmove_done               \n\
+            .memmove_back:                      \n\
             leal    -1(%%esi, %%ecx), %%esi     \n\
             leal    -1(%%edi, %%ecx), %%edi     \n\
             std                                 \n\
-            .memmove_go:                        \n\
             rep     movsb                       \n\
+            cld                                 \n\
+            .memmove_done:                      \n\
             "
             :
             : "D"(dest), "S"(src), "c"(n)
@@ -544,28 +655,26 @@ int8_t* strncpy(int8_t* dest, const int8_t* src, uint32_t n) {
  * Return Value: void
  * Function: increments video memory. To be used to test rtc */
 void test_interrupts(void) {
-    int32_t i;
-    for (i = 0; i < NUM_ROWS * NUM_COLS; i++) {
-        video_mem[i << 1]++;
+    int32_t row;
+    int32_t col;
+    for (row = 0; row < NUM_ROWS; row++) {
+        for (col = 0; col < NUM_COLS; col++) {
+            ((uint8_t *) SCREEN_ROW(screen_terminal, row))[col << 1]++;
+        }
     }
+    dirty_rows[screen_terminal] = ALL_ROWS_DIRTY;
+    console_written();
 }
 
-/*  check_size()
- * Inputs: None
+/*  check_size(int32_t term)
+ * Inputs: int32_t term = terminal that was printed on
  * Return Value: None
  * Function: Checks the position of x and y to see if its out of bounds. */
-void check_size(){
-    int true_terminal = screen_terminal;
-
-    /* Checks what terminal we are trying to edit. */
-    if(terminal_flag == 1) {
-        true_terminal = curr_terminal;
-    }
-
+void check_size(int32_t term){
     /* If we go out of bounds in the x direction, make screen_x = 0 and move screen_y down one row. */
-    if (terminal_array[true_terminal].screen_x >= NUM_COLS){ 
-        terminal_array[true_terminal].screen_y++;
-        terminal_array[true_terminal].screen_x = 0;
+    if (terminal_array[term].screen_x >= NUM_COLS){ 
+        terminal_array[term].screen_y++;
+        terminal_array[term].screen_x = 0;
     }
 }
 
@@ -575,7 +684,6 @@ void check_size(){
  * Function: Deletes a character from the screen of the terminal that we are looking at. */
 void erase_char(){
     /*erase_char is only used by typing triggerd cursor movement, meaning only screen terminal*/
-    terminal_flag = 0;
     /* Deletes the previous character. */
     terminal_array[screen_terminal].screen_x--;
 
@@ -584,21 +692,158 @@ void erase_char(){
         terminal_array[screen_terminal].screen_x = NUM_COLS-1;
         terminal_array[screen_terminal].screen_y--;
     }
-    *(uint8_t *)(video_mem + ((NUM_COLS * terminal_array[screen_terminal].screen_y + terminal_array[screen_terminal].screen_x) << 1)) = 0x0;
+    *(uint8_t *) &SCREEN_ROW(screen_terminal, terminal_array[screen_terminal].screen_y)[terminal_array[screen_terminal].screen_x] = 0x0;
+    dirty_rows[screen_terminal] |= 1 << terminal_array[screen_terminal].screen_y;
 
     /* Moves the cursor*/
     move_cursor();
+    console_written();
+}
+
+/*  display_terminal(int32_t term)
+ * Inputs: int32_t term = terminal to show
+ * Return Value: None
+ * Function: Points the VGA start address at the terminal's page of text memory and moves the cursor there,
+ *           so switching terminals copies nothing. Call with interrupts off. */
+void display_terminal(int32_t term){
+    uint16_t start = term * PAGE_CELLS;
+
+    screen_terminal = term;
+    outb(CRTC_START_LOW_REG, CRTC_ADDR_PORT);
+    outb((uint8_t)(start & GET_8_BITS), CRTC_DATA_PORT);
+    outb(CRTC_START_HIGH_REG, CRTC_ADDR_PORT);
+    outb((uint8_t)((start >> GET_8_MSB) & GET_8_BITS), CRTC_DATA_PORT);
+    move_cursor();
+    console_flush();
+}
+
+/*  scroll_view(int32_t term, int32_t rows)
+ * Inputs: int32_t term = terminal to scroll
+ *         int32_t rows = rows to move back into the scrollback, negative to move toward the live screen
+ * Return Value: None
+ * Function: Changes which rows of the ring the terminal shows. Only the view moves, the rows stay where
+ *           they are and console_flush copies the new window out of the ring. Does nothing while a process
+ *           draws on the terminal's page through vidmap. */
+void scroll_view(int32_t term, int32_t rows){
+    int32_t back = view_back[term] + rows;
+
+    if (vidmap_users[term]) {
+        return;
+    }
+    if (back > history_rows[term]) {
+        back = history_rows[term];
+    }
+    if (back < 0) {
+        back = 0;
+    }
+    if (back == view_back[term]) {
+        return;
+    }
+    view_back[term] = back;
+    dirty_rows[term] = ALL_ROWS_DIRTY;
+    move_cursor();
+    console_written();
+}
+
+/*  view_live(int32_t term)
+ * Inputs: int32_t term = terminal to scroll
+ * Return Value: None
+ * Function: Goes back from the scrollback to the live screen. */
+void view_live(int32_t term){
+    scroll_view(term, -view_back[term]);
+}
+
+/*  console_vidmap(int32_t term)
+ * Inputs: int32_t term = terminal whose page of text memory a process mapped
+ * Return Value: None
+ * Function: Stops console_flush from copying the console over what the process draws, and returns the
+ *           view to the live screen for when it is drawn again. Call with interrupts off. */
+void console_vidmap(int32_t term){
+    vidmap_users[term]++;
+    view_back[term] = 0;
+}
+
+/*  console_vidmap_release(int32_t term)
+ * Inputs: int32_t term = terminal whose page of text memory a halting process had mapped
+ * Return Value: None
+ * Function: Once no process has the page mapped, redraws the console over it. Call with interrupts off. */
+void console_vidmap_release(int32_t term){
+    if (--vidmap_users[term] == 0) {
+        dirty_rows[term] = ALL_ROWS_DIRTY;
+    }
 }
 
 /*  move_cursor()
  * Inputs: None
  * Return Value: None
- * Function: Moves the cursor based on the position of x and y*/
+ * Function: Notes that the cursor moved, console_flush moves the hardware cursor. */
 void move_cursor(){
+    cursor_moved = 1;
+}
+
+/*  console_dirty()
+ * Inputs: None
+ * Return Value: 1 if some output hasn't reached the screen yet, 0 otherwise
+ * Function: Lets the scheduler come back within a tick to flush it. */
+int32_t console_dirty(){
+    int32_t term;
+
+    for (term = 0; term < MAX_TERMINALS; term++) {
+        if (dirty_rows[term]) {
+            return 1;
+        }
+    }
+    return cursor_moved;
+}
+
+/*  console_flush()
+ * Inputs: None
+ * Return Value: None
+ * Function: Copies the rows of each terminal's console that changed since the last flush to its page of text
+ *           memory, each run of dirty rows in one copy, then moves the hardware cursor. A terminal showing
+ *           scrollback has its whole window copied, since its rows no longer line up with the screen's.
+ *           Pages a process drew on through vidmap are skipped. Called on every PIT interrupt and before the
+ *           CPU idles, so however much is printed, the screen is touched at most once a tick. Call with
+ *           interrupts off. */
+void console_flush(){
     uint16_t position;
+    int32_t term;
+    int32_t row;
+    int32_t end;
+
+    for (term = 0; term < MAX_TERMINALS; term++) {
+        if (vidmap_users[term]) {
+            dirty_rows[term] = 0;
+            continue;
+        }
+        if (view_back[term] && dirty_rows[term]) {
+            dirty_rows[term] = ALL_ROWS_DIRTY;
+        }
+        for (row = 0; row < NUM_ROWS; row = end) {
+            if (!(dirty_rows[term] & (1 << row))) {
+                end = row + 1;
+                continue;
+            }
+            for (end = row + 1; end < NUM_ROWS && (dirty_rows[term] & (1 << end)); end++);
+            copy_rows(term, row, end);
+        }
+        dirty_rows[term] = 0;
+    }
+
+    if (!cursor_moved) {
+        return;
+    }
+    cursor_moved = 0;
 
-    /* Use the screen_x and screen_y of the terminal that we are currently looking at. */
-    position = terminal_array[screen_terminal].screen_y* NUM_COLS + terminal_array[screen_terminal].screen_x;
+    /* Use the screen_x and screen_y of the terminal that we are currently looking at, inside its page. */
+    row = terminal_array[screen_terminal].screen_y + view_back[screen_terminal];
+    if (row >= NUM_ROWS) {
+        /* Scrolled out of view, park it in the part of the page past the bottom row. */
+        position = screen_terminal * PAGE_CELLS + NUM_ROWS * NUM_COLS;
+    }
+    else {
+        position = screen_terminal * PAGE_CELLS + row * NUM_COLS + terminal_array[screen_terminal].screen_x;
+    }
 
     /* Edit ports to move the cursor. */
     outb(CURSOR_LOC_LOW_REG, CRTC_ADDR_PORT);
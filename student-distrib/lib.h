@@ -8,13 +8,21 @@
 
 #include "types.h"
 
+/* Text mode video memory and the size of a console */
+#define VIDEO       0xB8000
+#define NUM_COLS    80
+#define NUM_ROWS    25
+
 int32_t printf(int8_t *format, ...);
 void putc(uint8_t c);
+void term_putc(int32_t term, uint8_t c);
+int32_t putbuf(int32_t term, const uint8_t* buf, int32_t n);
 int32_t puts(int8_t *s);
 int8_t *itoa(uint32_t value, int8_t* buf, int32_t radix);
 int8_t *strrev(int8_t* s);
 uint32_t strlen(const int8_t* s);
 void clear(void);
+void term_clear(int32_t term);
 
 void* memset(void* s, int32_t c, uint32_t n);
 void* memset_word(void* s, int32_t c, uint32_t n);
@@ -25,9 +33,16 @@ int32_t strncmp(const int8_t* s1, const int8_t* s2, uint32_t n);
 int8_t* strcpy(int8_t* dest, const int8_t*src);
 int8_t* strncpy(int8_t* dest, const int8_t*src, uint32_t n);
 void test_interrupts();
-void check_size();
+void check_size(int32_t term);
 void erase_char();
 void move_cursor();
+void display_terminal(int32_t term);
+void scroll_view(int32_t term, int32_t rows);
+void view_live(int32_t term);
+void console_vidmap(int32_t term);
+void console_vidmap_release(int32_t term);
+int32_t console_dirty();
+void console_flush();
 
 /* Userspace address-check functions */
 int32_t bad_userspace_addr(const void* addr, int32_t len);
@@ -77,6 +92,16 @@ static inline uint32_t inl(port) {
     return val;
 }
 
+/* Reads the time-stamp counter and returns its low 32 bits. Good enough
+ * for timing anything shorter than a second or so. */
+static inline uint32_t rdtsc(void) {
+    uint32_t low, high;
+    asm volatile ("rdtsc"
+            : "=a"(low), "=d"(high)
+    );
+    return low;
+}
+
 /* Writes a byte to a port */
 #define outb(data, port)                \
 do {                                    \
@@ -1,4 +1,6 @@
 #include "page.h"
+#include "frame.h"
+#include "lib.h"
 
 
 /*
@@ -78,17 +80,14 @@ void init_page() {
 
     mem = VIDEO_ADDR / ALIGN;   // gets index of video memory in page table
 
-    /*Video Page for Screen*/
+    /*Video Page for Terminal 0, the screen shows one of the three*/
     page_table[mem].present = 1;   // present
-
-    /*Video Page for Terminal 0*/
-    page_table[mem+1].present = 1;   // present
     
     /*Video Page for Terminal 1*/
-    page_table[mem+2].present = 1;   // present
+    page_table[mem+1].present = 1;   // present
 
     /*Video Page for Terminal 2*/
-    page_table[mem+3].present = 1;   // present
+    page_table[mem+2].present = 1;   // present
 
 
 
@@ -98,4 +97,60 @@ void init_page() {
     enablePaging();
 }
 
+/*
+ * map_user_page
+ *   DESCRIPTION: points the page table entry for vaddr in a process's user page table at a frame
+ *   INPUTS: pid -- process whose page table to change
+ *           vaddr -- user virtual address inside the 4 MB user region
+ *           frame -- physical address of the frame
+ *           avail -- 0 for a frame the process owns, or PTE_SHARED and PTE_COW
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: the page is user accessible, and writable only if the process owns the frame;
+ *                 flush the TLB if it replaces a present page
+ */
+void map_user_page(uint32_t pid, uint32_t vaddr, uint32_t frame, uint32_t avail) {
+    page_table_entry_t* entry = &user_page_tables[pid][PTE_INDEX(vaddr)];
+
+    entry->present = 1;
+    entry->read_write = (avail == 0);
+    entry->user_supervisor = 1;
+    entry->accessed = 0;
+    entry->dirty = 0;
+    entry->avail = avail;
+    entry->base_addr = frame >> shift_12;
+}
+
+/*
+ * free_user_pages
+ *   DESCRIPTION: gives every frame the process owns in its user page table back to the frame allocator
+ *   INPUTS: pid -- process whose user memory to free
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: empties the page table; flush the TLB if it is the one in use
+ */
+void free_user_pages(uint32_t pid) {
+    unsigned int i;   // looping variable
+
+    for (i = 0; i < PAGE_SIZE; i++) {
+        if (user_page_tables[pid][i].present && !(user_page_tables[pid][i].avail & PTE_SHARED)) {
+            free_frame(user_page_tables[pid][i].base_addr << shift_12);
+        }
+    }
+    memset(user_page_tables[pid], 0, sizeof(user_page_tables[pid]));
+}
 
+/*
+ * map_scratch_page
+ *   DESCRIPTION: maps any physical frame at SCRATCH_ADDR; the kernel only sees the first 8 MB otherwise
+ *   INPUTS: frame -- physical address of the frame
+ *   OUTPUTS: none
+ *   RETURN VALUE: SCRATCH_ADDR
+ *   SIDE EFFECTS: replaces the previous scratch mapping and flushes the TLB. Call with interrupts off.
+ */
+void* map_scratch_page(uint32_t frame) {
+    page_table[PTE_INDEX(SCRATCH_ADDR)].present = 1;
+    page_table[PTE_INDEX(SCRATCH_ADDR)].base_addr = frame >> shift_12;
+    flushTLB();
+    return (void*) SCRATCH_ADDR;
+}
@@ -4,6 +4,7 @@
 #ifndef ASM
 
 #include "types.h"
+#include "syscalls.h"
 
 #define ALIGN           4096        // alignment
 #define PAGE_SIZE       1024        // total entry size of each page
@@ -14,6 +15,14 @@
 #define shift_12    12
 #define shift_22    22
 
+#define SCRATCH_ADDR    0x3FF000    // last page of the first 4 MB, borrowed to reach frames above 8 MB
+
+/* page table entry avail bits for user pages */
+#define PTE_SHARED  0x1     // frame isn't owned by the process (file system image), never freed
+#define PTE_COW     0x2     // read-only until written, a write fault gives the process its own copy
+
+#define PTE_INDEX(vaddr)    (((vaddr) >> shift_12) & (PAGE_SIZE - 1))  // entry for vaddr in its page table
+
 /* loads page directory */
 extern void loadPageDirectory(unsigned int*);
 /* enables paging */
@@ -23,6 +32,13 @@ extern void flushTLB();
 /* initializes paging */
 extern void init_page();
 
+/* maps a 4 kB frame into a process's user page table */
+void map_user_page(uint32_t pid, uint32_t vaddr, uint32_t frame, uint32_t avail);
+/* maps a frame at SCRATCH_ADDR so the kernel can reach it */
+void* map_scratch_page(uint32_t frame);
+/* frees every frame mapped in a process's user page table and empties it */
+void free_user_pages(uint32_t pid);
+
 /* kb page directory entry structure */
 typedef struct __attribute__((packed)) page_directory_entry_kb {
     uint8_t present             : 1;
@@ -81,6 +97,8 @@ page_directory_entry_t page_directory[PAGE_SIZE] __attribute__ ((aligned(ALIGN))
 /* page table */
 page_table_entry_t page_table[PAGE_SIZE] __attribute__ ((aligned(ALIGN)));
 page_table_entry_t vid_map[PAGE_SIZE] __attribute__ ((aligned(ALIGN)));
+/* page table for the 4 MB user region (page directory entry 32) of each process */
+page_table_entry_t user_page_tables[NUM_PROCESSES][PAGE_SIZE] __attribute__ ((aligned(ALIGN)));
 
 #endif /* ASM */
 
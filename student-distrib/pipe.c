@@ -0,0 +1,274 @@
+/* Anonymous pipes */
+
+#include "pipe.h"
+#include "lib.h"
+#include "sched.h"
+#include "syscalls.h"
+
+pipe_t pipes[MAX_PIPES];
+
+/* 
+ * init_pipes
+ *   DESCRIPTION: Marks every pipe free.
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: Resets the pipe table.
+ */
+void init_pipes() {
+    int i;
+
+    for (i = 0; i < MAX_PIPES; i++) {
+        pipes[i].readers = 0;
+        pipes[i].writers = 0;
+    }
+}
+
+/* 
+ * system_pipe
+ *   DESCRIPTION: Creates a pipe and opens both of its ends in the caller's fd array.
+ *   INPUTS: fds -- user array of two fds, filled with the read end then the write end
+ *   OUTPUTS: none
+ *   RETURN VALUE: 0 on success; -1 if fds is bad, or there is no free pipe or fd
+ *   SIDE EFFECTS: Takes a pipe and two fd slots.
+ */
+int32_t system_pipe(int32_t* fds) {
+    pcb_t* pcb = get_pcb(curr_pid);
+    fd_t* ends[2];
+    int32_t fd_index[2];
+    int32_t index = -1;
+    int32_t i;
+    int32_t n = 0;
+
+    if (fds == NULL || (uint32_t) fds < ONE_TWENTY_EIGHT_MB || (uint32_t) fds > USER_REGION_END - 2 * sizeof(int32_t)) {
+        return -1;
+    }
+
+    // the two lowest free fds
+    for (i = FILE_DESCRIPTOR_MIN; i < FILE_DESCRIPTOR_MAX && n < 2; i++) {
+        if (pcb->file_descriptors[i].flags == NOT_IN_USE) {
+            fd_index[n++] = i;
+        }
+    }
+    if (n < 2) {
+        return -1;
+    }
+
+    cli();
+    for (i = 0; i < MAX_PIPES; i++) {
+        if (pipes[i].readers == 0 && pipes[i].writers == 0) {
+            index = i;
+            break;
+        }
+    }
+    if (index == -1) {
+        sti();
+        return -1;
+    }
+    pipes[index].head = 0;
+    pipes[index].count = 0;
+    pipes[index].readers = 1;
+    pipes[index].writers = 1;
+    init_wait_queue(&pipes[index].read_queue);
+    init_wait_queue(&pipes[index].write_queue);
+    sti();
+
+    for (i = 0; i < 2; i++) {
+        ends[i] = &pcb->file_descriptors[fd_index[i]];
+        ends[i]->inode = index;
+        ends[i]->file_pos = 0;
+        ends[i]->flags = IN_USE;
+    }
+    ends[0]->file_op_table_ptr = &pipe_read_ops;
+    ends[1]->file_op_table_ptr = &pipe_write_ops;
+
+    fds[0] = fd_index[0];
+    fds[1] = fd_index[1];
+    return 0;
+}
+
+/* 
+ * pipe_ref
+ *   DESCRIPTION: Counts one more reference to a pipe end. Called whenever an fd_t is copied,
+ *                by fork, spawn and dup2. Other kinds of fd need no counting.
+ *   INPUTS: fd -- the new copy of the fd
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: The pipe stays open until this copy is closed too.
+ */
+void pipe_ref(fd_t* fd) {
+    if (fd->flags == NOT_IN_USE) {
+        return;
+    }
+    if (fd->file_op_table_ptr == &pipe_read_ops) {
+        pipes[fd->inode].readers++;
+    } else if (fd->file_op_table_ptr == &pipe_write_ops) {
+        pipes[fd->inode].writers++;
+    }
+}
+
+/* 
+ * pipe_read
+ *   DESCRIPTION: Copies out whatever the pipe holds, up to nbytes. While the pipe is empty the
+ *                process sleeps on its read queue until a writer adds data or the last writer closes.
+ *   INPUTS: fd -- read end of the pipe
+ *           buf -- buffer to copy into
+ *           nbytes -- most bytes to read
+ *   OUTPUTS: none
+ *   RETURN VALUE: bytes read, 0 at end of file (no writers left), -1 on failure
+ *   SIDE EFFECTS: Wakes writers blocked on a full pipe.
+ */
+int32_t pipe_read(int32_t fd, void* buf, int32_t nbytes) {
+    pipe_t* pipe = &pipes[get_pcb(curr_pid)->file_descriptors[fd].inode];
+    uint32_t chunk;
+    uint32_t n;
+
+    if (buf == NULL || nbytes < 0) {
+        return -1;
+    }
+    if (nbytes == 0) {
+        return 0;
+    }
+
+    cli();
+    while (pipe->count == 0) {
+        if (pipe->writers == 0) {
+            sti();
+            return 0;
+        }
+        sleep_on(&pipe->read_queue);
+        cli();
+    }
+
+    // at most two copies, the second one after the ring wraps around
+    n = (pipe->count < (uint32_t) nbytes) ? pipe->count : (uint32_t) nbytes;
+    chunk = (n < PIPE_SIZE - pipe->head) ? n : PIPE_SIZE - pipe->head;
+    memcpy(buf, pipe->data + pipe->head, chunk);
+    memcpy((uint8_t*) buf + chunk, pipe->data, n - chunk);
+    pipe->head = (pipe->head + n) % PIPE_SIZE;
+    pipe->count -= n;
+
+    wake_up(&pipe->write_queue);
+    sti();
+    return n;
+}
+
+/* 
+ * pipe_write
+ *   DESCRIPTION: Copies nbytes into the pipe. Whenever the pipe is full the process sleeps on its
+ *                write queue until a reader makes room.
+ *   INPUTS: fd -- write end of the pipe
+ *           buf -- buffer to copy from
+ *           nbytes -- bytes to write
+ *   OUTPUTS: none
+ *   RETURN VALUE: nbytes; the bytes written so far if the last reader closes, -1 if that was none
+ *   SIDE EFFECTS: Wakes readers blocked on an empty pipe.
+ */
+int32_t pipe_write(int32_t fd, const void* buf, int32_t nbytes) {
+    pipe_t* pipe = &pipes[get_pcb(curr_pid)->file_descriptors[fd].inode];
+    uint32_t tail;
+    uint32_t chunk;
+    uint32_t n;
+    int32_t written = 0;
+
+    if (buf == NULL || nbytes < 0) {
+        return -1;
+    }
+
+    cli();
+    while (written < nbytes) {
+        // nobody will ever read it
+        if (pipe->readers == 0) {
+            sti();
+            return (written > 0) ? written : -1;
+        }
+        if (pipe->count == PIPE_SIZE) {
+            sleep_on(&pipe->write_queue);
+            cli();
+            continue;
+        }
+
+        n = PIPE_SIZE - pipe->count;
+        if (n > (uint32_t) (nbytes - written)) {
+            n = nbytes - written;
+        }
+        tail = (pipe->head + pipe->count) % PIPE_SIZE;
+        chunk = (n < PIPE_SIZE - tail) ? n : PIPE_SIZE - tail;
+        memcpy(pipe->data + tail, (const uint8_t*) buf + written, chunk);
+        memcpy(pipe->data, (const uint8_t*) buf + written + chunk, n - chunk);
+        pipe->count += n;
+        written += n;
+
+        wake_up(&pipe->read_queue);
+    }
+    sti();
+    return written;
+}
+
+/* 
+ * pipe_read_end_write
+ *   DESCRIPTION: Refuses a write to the read end of a pipe.
+ *   INPUTS: fd -- file descriptor
+ *           buf -- ignored
+ *           nbytes -- ignored
+ *   OUTPUTS: none
+ *   RETURN VALUE: -1
+ *   SIDE EFFECTS: none
+ */
+int32_t pipe_read_end_write(int32_t fd, const void* buf, int32_t nbytes) {
+    return -1;
+}
+
+/* 
+ * pipe_write_end_read
+ *   DESCRIPTION: Refuses a read from the write end of a pipe.
+ *   INPUTS: fd -- file descriptor
+ *           buf -- ignored
+ *           nbytes -- ignored
+ *   OUTPUTS: none
+ *   RETURN VALUE: -1
+ *   SIDE EFFECTS: none
+ */
+int32_t pipe_write_end_read(int32_t fd, void* buf, int32_t nbytes) {
+    return -1;
+}
+
+/* 
+ * pipe_buffered
+ *   DESCRIPTION: Tells how much data a pipe holds, for fstat.
+ *   INPUTS: fd -- either end of a pipe
+ *   OUTPUTS: none
+ *   RETURN VALUE: bytes written and not yet read
+ *   SIDE EFFECTS: none
+ */
+uint32_t pipe_buffered(fd_t* fd) {
+    return pipes[fd->inode].count;
+}
+
+/* 
+ * pipe_close
+ *   DESCRIPTION: Drops one reference to a pipe end. Closing the last write end wakes readers so they
+ *                see end of file, closing the last read end wakes writers so they give up.
+ *   INPUTS: fd -- either end of a pipe, still filled in
+ *   OUTPUTS: none
+ *   RETURN VALUE: 0
+ *   SIDE EFFECTS: The pipe is free again once both counts reach 0.
+ */
+int32_t pipe_close(int32_t fd) {
+    fd_t* end = &get_pcb(curr_pid)->file_descriptors[fd];
+    pipe_t* pipe = &pipes[end->inode];
+    uint32_t flags;
+
+    cli_and_save(flags);
+    if (end->file_op_table_ptr == &pipe_read_ops) {
+        if (--pipe->readers == 0) {
+            wake_up(&pipe->write_queue);
+        }
+    } else {
+        if (--pipe->writers == 0) {
+            wake_up(&pipe->read_queue);
+        }
+    }
+    restore_flags(flags);
+    return 0;
+}
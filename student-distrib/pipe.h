@@ -0,0 +1,50 @@
+#ifndef _PIPE_H_
+#define _PIPE_H_
+
+#include "types.h"
+#include "sched.h"
+#include "syscalls.h"
+
+#define MAX_PIPES   8       /* pipes open at once across all processes */
+#define PIPE_SIZE   4096    /* bytes a pipe holds before writers block */
+
+/* A one-way byte stream between processes. The read end's fd_t and the write end's fd_t
+ * keep the index of their pipe in fd_t.inode. */
+typedef struct pipe {
+    uint8_t data[PIPE_SIZE];    /* ring buffer */
+    uint32_t head;              /* index of the next byte to read */
+    uint32_t count;             /* bytes in the buffer */
+    int32_t readers;            /* open read ends, across every process's fd array */
+    int32_t writers;            /* open write ends */
+    wait_queue_t read_queue;    /* readers blocked on an empty pipe */
+    wait_queue_t write_queue;   /* writers blocked on a full pipe */
+} pipe_t;
+
+/* Marks every pipe free */
+void init_pipes();
+
+/* Creates a pipe, puts its read end in fds[0] and its write end in fds[1] */
+int32_t system_pipe(int32_t* fds);
+
+/* Counts one more reference to a pipe end that was copied into another fd slot */
+void pipe_ref(fd_t* fd);
+
+/* Takes up to nbytes out of the pipe, blocking while it is empty */
+int32_t pipe_read(int32_t fd, void* buf, int32_t nbytes);
+
+/* Puts all nbytes into the pipe, blocking while it is full */
+int32_t pipe_write(int32_t fd, const void* buf, int32_t nbytes);
+
+/* Fails, the read end can't be written */
+int32_t pipe_read_end_write(int32_t fd, const void* buf, int32_t nbytes);
+
+/* Fails, the write end can't be read */
+int32_t pipe_write_end_read(int32_t fd, void* buf, int32_t nbytes);
+
+/* Bytes waiting in the pipe an fd is an end of */
+uint32_t pipe_buffered(fd_t* fd);
+
+/* Drops one reference to a pipe end, frees the pipe when both ends are gone */
+int32_t pipe_close(int32_t fd);
+
+#endif
@@ -2,61 +2,183 @@
 #include "terminal.h"
 #include "syscalls.h"
 #include "page.h"
+#include "sched.h"
+
+/* Set while the scheduler is halted waiting for a process to become runnable. */
+volatile int sched_idle = 0;
+
+/* Timer overhead counters, see pit.h */
+volatile uint32_t pit_interrupts = 0;
+volatile uint32_t sched_calls = 0;
+volatile uint32_t pit_reprograms = 0;
+
+/* CPU share counters, see pit.h */
+volatile uint32_t sched_busy_cycles = 0;
+volatile uint32_t sched_idle_cycles = 0;
+
+/* Input clocks the PIT was last armed with, 0 while it is stopped. */
+static uint32_t pit_armed = 0;
 
 /* init_pit
- * DESCRIPTION: Initializes the PIT by enabling IRQ0 on the PIC, turning on square wave interrupts on the pit,
- *                and setting the PIC frequency to the intended rate.
+ * DESCRIPTION: Initializes the PIT by enabling IRQ0 on the PIC and putting channel 0 in one-shot mode.
  * Inputs: none
  * Outputs: none
  * Return Value: none
- * Function: Allows for the PIT to send periodic interrupts.
+ * Function: The PIT stays quiet until the first process is executed and arms it for its time slice.
  */
 void init_pit() {
-    /* Use channel 0 and a square wave generator. */
-    int divisor = INPUT_CLOCK_HZ / RATE;       /* Calculate our divisor by dividing the max frequency of the PIT by the rate that we want. */
-    outb(SET_CHANNEL_0, COMMAND_REGISTER);             /* Set our command byte 0x36 */
-    outb(divisor & LOW_BYTE, CHANNEL_0);   /* Set low byte of divisor */
-    outb(divisor >> HIGH_BYTE, CHANNEL_0);     /* Set high byte of divisor */
+    /* Writing the mode alone stops channel 0 until a count is loaded. */
+    outb(SET_ONE_SHOT, COMMAND_REGISTER);
+    pit_armed = 0;
     base_shell = 1;
 
     /* Enables the IRQ of the PIT*/
     enable_irq(PIT_IRQ);
 }
 
+/* pit_one_shot
+ * DESCRIPTION: Loads a new count into channel 0 in mode 0, replacing whatever was armed before.
+ * Inputs: count -- input clocks until the interrupt, clamped to 1 through PIT_MAX_COUNT
+ * Outputs: none
+ * Return Value: none
+ * Function: Raises IRQ0 once when the count runs out.
+ */
+void pit_one_shot(uint32_t count) {
+    if (count == 0) {
+        count = 1;
+    } else if (count > PIT_MAX_COUNT) {
+        count = PIT_MAX_COUNT;
+    }
+    outb(SET_ONE_SHOT, COMMAND_REGISTER);
+    outb(count & LOW_BYTE, CHANNEL_0);
+    outb(count >> HIGH_BYTE, CHANNEL_0);
+    pit_armed = count;
+    pit_reprograms++;
+}
+
+/* pit_stop
+ * DESCRIPTION: Stops channel 0 and works out how long it ran since pit_one_shot.
+ * Inputs: none
+ * Outputs: none
+ * Return Value: input clocks that passed, the whole armed count if it already ran out, 0 if it wasn't armed
+ * Function: Lets the scheduler charge a process for the part of its slice it actually used.
+ */
+uint32_t pit_stop() {
+    uint32_t elapsed;
+    uint32_t count;
+
+    if (pit_armed == 0) {
+        return 0;
+    }
+
+    /* Once a mode 0 count runs out the counter wraps and keeps going, so check the output pin first. */
+    outb(READ_BACK_STATUS, COMMAND_REGISTER);
+    if (inb(CHANNEL_0) & OUT_PIN_HIGH) {
+        elapsed = pit_armed;
+    } else {
+        outb(LATCH_COUNT, COMMAND_REGISTER);
+        count = inb(CHANNEL_0);
+        count |= inb(CHANNEL_0) << HIGH_BYTE;
+        elapsed = (count <= pit_armed) ? pit_armed - count : pit_armed;
+    }
+
+    outb(SET_ONE_SHOT, COMMAND_REGISTER);
+    pit_armed = 0;
+    return elapsed;
+}
+
 /* pit_handler
  * DESCRIPTION: Function called by IDT through PIT interrupts that calls scheduler helper function.
  * Inputs: none
  * Outputs: none
  * Return Value: none
- * Function: Allows for round robin scheduling
+ * Function: Flushes console output to the screen. Preempts the running process at the end of its time slice,
+ *           or as soon as a process on a higher priority level becomes runnable. Otherwise rearms the PIT for
+ *           what is left of the slice.
  */
 void pit_handler() {   
     // Call the scheduler
     cli();
     send_eoi(PIT_IRQ);
-    scheduler();
+    pit_interrupts++;
+
+    /* Whatever was printed since the last tick goes to the screen now, in one pass. */
+    console_flush();
+
+    /* A one-shot that went off just as the CPU went idle, or before anything was started: nothing to switch. */
+    if (sched_idle || curr_pid == NO_PID) {
+        return;
+    }
+
+    /* Only switch when the time slice is used up, a higher level has work, or a shell still needs starting. */
+    if (sched_tick() || next_unstarted_terminal() != -1) {
+        scheduler();
+    }
+}
+
+/* sched_halt
+ * DESCRIPTION: Waits for an interrupt with nothing runnable and adds the wait to sched_idle_cycles.
+ * Inputs: none
+ * Outputs: none
+ * Return Value: none
+ * Function: The PIT is stopped, so the wait is timed with rdtsc. Call with interrupts off, they are off again
+ *           when it returns.
+ */
+void sched_halt() {
+    uint32_t start;
+
+    /* No tick is coming while idle, so show pending output (keyboard echo included) before halting. */
+    console_flush();
+
+    sched_idle = 1;
+    start = rdtsc();
+    asm volatile("sti; hlt; cli" : : : "memory");
+    sched_idle_cycles += rdtsc() - start;
+    sched_idle = 0;
+}
+
+/* next_unstarted_terminal
+ * DESCRIPTION: Finds a terminal whose base shell hasn't been executed yet.
+ * Inputs: none
+ * Outputs: none
+ * Return Value: terminal index, or -1 if every terminal has a shell
+ * Function: Lets the scheduler bring up the shells of terminal 1 and 2 on its first passes.
+ */
+int next_unstarted_terminal() {
+    int terminal;
+
+    for (terminal = 0; terminal < MAX_TERMINALS; terminal++) {
+        if (terminal_array[terminal].flag == 0) {
+            return terminal;
+        }
+    }
+    return -1;
 }
 
 /* scheduler
- * DESCRIPTION: Function called by pit_handler that handls all our round-robin scheduling logic.
+ * DESCRIPTION: Function called by pit_handler that handles all our multilevel feedback queue scheduling logic.
  * Inputs: none
  * Outputs: none
  * Return Value: none
- * Function: Switches between processes and executes base shells of terminal 1 and 2.
+ * Function: Puts the running process at the back of the run queue for its level (unless it just blocked) and
+ *           switches to the front of the highest non-empty level, round-robin within a level no matter which
+ *           terminal a process belongs to. If nothing is runnable the CPU halts until an interrupt wakes a process up.
+ *           Spawns the base shells of terminal 1 and 2 the first time they come around.
+ *           Called from pit_handler, directly by sleep_on when a process blocks, by halt, and by the kernel
+ *           to start the first shell.
+ *           The PIT is rearmed for the rest of the next process's slice.
  */
 void scheduler() {
-    pcb_t* old_pcb = get_pcb(terminal_array[curr_terminal].pid);
+    pcb_t* old_pcb;
     pcb_t* next_pcb;
     int next_pid = -1;
+    int new_terminal;
     
     // Temp variables to hold ebp and esp
     uint32_t temp_esp;
     uint32_t temp_ebp;
 
-    //move to next scheduled terminal (0->1->2->0->....)
-    curr_terminal = (curr_terminal + 1) % MAX_TERMINALS;
-    
-    /* Getting the ebp and esp of the current terminal. */
+    /* Getting the ebp and esp of the current process. */
     asm volatile("                     \n\
           movl %%ebp, %0               \n\
           movl %%esp, %1               \n\
@@ -66,39 +188,60 @@ void scheduler() {
           : "eax"
           );
 
-    /* Storing the ebp and esp of the current terminal onto the stack. */
-    old_pcb->ebp = temp_ebp;
-    old_pcb->esp = temp_esp;
+    sched_calls++;
+
+    /* Charge the slice the old process used. The PIT stays stopped until the next process is picked. */
+    sched_charge();
+
+    /* Nothing to save when the kernel starts the first process. */
+    if (curr_pid != NO_PID) {
+        /* Storing the ebp and esp of the current process in its pcb. */
+        old_pcb = get_pcb(curr_pid);
+        old_pcb->ebp = temp_ebp;
+        old_pcb->esp = temp_esp;
 
-    /* Opening a new shell if the flag is set to 0. */
-    if (terminal_array[curr_terminal].flag == 0) {
+        /* A preempted process goes to the back of the line, a blocked one or a zombie waits. */
+        if (old_pcb->state == PROCESS_RUNNING) {
+            make_runnable(curr_pid);
+        }
+    }
+
+    /* Spawning a new shell if a terminal doesn't have one yet. */
+    new_terminal = next_unstarted_terminal();
+    if (new_terminal != -1) {
+        curr_terminal = new_terminal;
         clear();
         terminal_array[curr_terminal].flag = 1;
         base_shell = 1;
-        system_execute((uint8_t *) "shell");
-        
+        system_spawn((uint8_t *) "shell");
     }
 
-    // get youngest process id of new terminal
-    next_pid = terminal_array[curr_terminal].pid;
-    
-    if(curr_terminal == screen_terminal){ //if current terminal being handled is screen terminal give vidmap addr to actual screen vid mem
-        vid_map[0].base_addr = (int) (VIDEO_ADDR / ALIGN); 
+    // take the next process off the run queue
+    next_pid = pick_next_process();
+    while (next_pid == NO_PID) {
+        /* Everyone is blocked: with the PIT stopped, sleep until another interrupt handler wakes somebody up. */
+        sched_halt();
+        next_pid = pick_next_process();
     }
-    else{ // else give vidmap addr to respective backup page
-        vid_map[0].base_addr = (int) (VIDEO_ADDR / ALIGN) + (curr_terminal+1);
-    }
-    
-    //get pcb of next process and handle process paging
+
     next_pcb = get_pcb(next_pid);
+    next_pcb->state = PROCESS_RUNNING;
+    curr_pid = next_pid;
+    curr_terminal = next_pcb->terminal_id;
+    sched_arm();
+    
+    // vidmap shows the process its terminal's page of text memory, on screen or not
+    vid_map[0].base_addr = (int) (VIDEO_ADDR / ALIGN) + curr_terminal;
+    
+    //handle process paging of next process
     process_page(next_pid);
     flushTLB();
 
     // Restoring tss
-    tss.esp0 = terminal_array[curr_terminal].base_tss_esp0;
-    tss.ss0 = terminal_array[curr_terminal].base_tss_ss0;
+    tss.esp0 = EIGHT_MB - next_pid * EIGHT_KB;
+    tss.ss0 = KERNEL_DS;
 
-    //going to stack of new terminal
+    //going to stack of next process
     asm volatile("                           \n\
                 movl %0, %%esp               \n\
                 movl %1, %%ebp               \n\
@@ -110,4 +253,3 @@ void scheduler() {
                 
     sti();
 }
-
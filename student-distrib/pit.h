@@ -12,18 +12,49 @@
 #define LOW_BYTE 0xFF
 #define HIGH_BYTE 8
 #define SET_CHANNEL_0 0x36
-#define RATE 100 /* Allows for the PIT to raise the IRQ about every 10 milliseconds */ 
+#define SET_ONE_SHOT 0x30   /* channel 0, low then high byte, mode 0: one interrupt when the count runs out */
+#define READ_BACK_STATUS 0xE2   /* latch the status byte of channel 0 */
+#define LATCH_COUNT 0x00    /* latch the current count of channel 0 */
+#define OUT_PIN_HIGH 0x80   /* status bit set once a one-shot count has run out */
+#define RATE 100 /* One scheduler tick is about 10 milliseconds */ 
+#define PIT_TICK_COUNT (INPUT_CLOCK_HZ / RATE)  /* PIT input clocks per tick */
+#define PIT_MAX_COUNT 0xFFFF
+#define PIT_KICK_COUNT 1    /* fire right away, used to preempt from another interrupt handler */
 
 int active_terminals[MAX_TERMINALS];
 
+/* Counters for measuring timer overhead: PIT interrupts taken (one send_eoi each), scheduler() calls,
+ * and how many times the PIT was reprogrammed. */
+extern volatile uint32_t pit_interrupts;
+extern volatile uint32_t sched_calls;
+extern volatile uint32_t pit_reprograms;
+
+/* rdtsc cycles spent running processes and halted with nothing runnable, so tests can compare CPU share.
+ * They wrap, compare differences over short windows. */
+extern volatile uint32_t sched_busy_cycles;
+extern volatile uint32_t sched_idle_cycles;
+
 /* The PIT is used for scheduling. The reason that we don't use RTC is because the RTC is not deterministic.
-User can change the RTC values whenever they want to, but they cannot change the PIT. */
+User can change the RTC values whenever they want to, but they cannot change the PIT.
+The PIT runs tickless: it is armed one-shot for the rest of the running process's time slice and stopped
+while nothing is runnable, so an idle CPU only wakes up for the RTC, the keyboard, etc. */
 
 /* Initalizes the Programmable Interrupt Timer. */
 void init_pit();
 
 void pit_handler();
 
+/* Arms the PIT to interrupt once after count input clocks */
+void pit_one_shot(uint32_t count);
+
+/* Stops the PIT and returns the input clocks that passed since it was armed */
+uint32_t pit_stop();
+
 void scheduler();
 
+/* Halts until the next interrupt, counting the wait as idle time */
+void sched_halt();
+
+int next_unstarted_terminal();
+
 #endif
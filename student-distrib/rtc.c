@@ -4,15 +4,18 @@
 #include "lib.h"
 #include "syscalls.h"
 #include "terminal.h"
+#include "sched.h"
 
 #define RTC_IRQ         8
 #define BYTE_4          4
 #define RATE_OFFSET     3
 
 int RTC_frequency;
-volatile int RTC_max_counter[MAX_TERMINALS]; // each terminal has it's own max
-volatile int RTC_block[MAX_TERMINALS]; //each terminal gets a separate RTC block
-volatile int RTC_counter[MAX_TERMINALS]; // each terminal gets a separate RTC counter
+wait_queue_t RTC_wait_queue; // processes blocked in RTC_read, each counting down its own virtual tick
+
+/* The virtual tick of the kernel itself, for RTC reads before any process has a PCB (kernel tests at boot). */
+static int32_t kernel_rtc_max_counter = rtc_max_usable_frequency / rtc_min_frequency;
+static volatile int32_t kernel_rtc_counter = 0;
 
 /* 
  * init_RTC
@@ -28,7 +31,6 @@ void init_RTC() {
 
     /* Source: https://wiki.osdev.org/RTC */
 
-    int i;
     /*Selects Register B and disables NMIs */
     outb(NMI_DISABLE_CMD | RTC_REG_B, RTC_REGISTER_SELECT);
 
@@ -55,11 +57,7 @@ void init_RTC() {
 
 
     /* initializes RTC variables */
-    for(i = 0; i < MAX_TERMINALS; i++){
-            RTC_block[i] = 0;
-            RTC_max_counter[i] = 1;
-            RTC_counter[i] = 1;
-    }
+    init_wait_queue(&RTC_wait_queue);
    
     /* Renables NMIs */
     /* Sets bit 7 to 0, renabling NMIs */
@@ -75,23 +73,31 @@ void init_RTC() {
 
 /* 
  * set_RTC_frequency
- *   DESCRIPTION: Sets the RTC to the specified virtual frequency.
+ *   DESCRIPTION: Sets the RTC to the specified virtual frequency for the current process.
  *   INPUTS: freq - The frequency we want to set the periodic interrupts to.
  *   OUTPUTS: none
  *   RETURN VALUE: none
  *   SIDE EFFECTS: none
  */
 void set_RTC_frequency(int freq) {
+    pcb_t* pcb;
+
     if (freq >= rtc_min_frequency && freq <= rtc_max_usable_frequency) {
         RTC_frequency = freq;
-        RTC_max_counter[curr_terminal] = rtc_max_usable_frequency / RTC_frequency;
-        RTC_counter[curr_terminal] = RTC_max_counter[curr_terminal];
+        if (curr_pid == NO_PID) {
+            kernel_rtc_max_counter = rtc_max_usable_frequency / RTC_frequency;
+            return;
+        }
+        pcb = get_pcb(curr_pid);
+        pcb->rtc_max_counter = rtc_max_usable_frequency / RTC_frequency;
+        pcb->rtc_counter = pcb->rtc_max_counter;
     }
 }
 
 /* 
  * RTC_handler
- *   DESCRIPTION: Handles interrupts from the RTC. After servicing, an EOI is sent to the PIC.
+ *   DESCRIPTION: Handles interrupts from the RTC. Counts down the virtual tick of every process blocked in
+ *                RTC_read and wakes the ones whose tick ran out. After servicing, an EOI is sent to the PIC.
  *   INPUTS: none
  *   OUTPUTS: none
  *   RETURN VALUE: none
@@ -99,22 +105,27 @@ void set_RTC_frequency(int freq) {
  */
 void RTC_handler() {
     uint8_t garbage;   // garbage
-    int i;
+    int32_t pid;   // sleeping process we are looking at
+    int32_t next_pid;   // the sleeper after it, saved since waking unlinks pid
+    pcb_t* pcb;
 
     /* Throws away the contents of Register C, allowing for interrupts to occur. */
     outb(RTC_REG_C, RTC_REGISTER_SELECT);
     garbage = inb(RTC_REGISTER_DATA_PORT);
 
-    for(i = 0; i < MAX_TERMINALS; i++){
-        // Sets RTC_counter for RTC_read
-        if (RTC_counter[i] == 0) { // once counter = 0 change block to 0 indicating a tick
-            RTC_block[i] = 0;
-            RTC_counter[i] = RTC_max_counter[i];
+    for (pid = RTC_wait_queue.head; pid != NO_PID; pid = next_pid) {
+        pcb = get_pcb(pid);
+        next_pid = pcb->wait_next;
+        if (pcb->rtc_counter == 0) { // once counter = 0 the process's virtual tick has happened
+            wake_process(&RTC_wait_queue, pid);
         } else {
-            RTC_counter[i]--; 
+            pcb->rtc_counter--;
         }
     }
-    
+    if (kernel_rtc_counter > 0) {
+        kernel_rtc_counter--;
+    }
+
 
     send_eoi(RTC_IRQ);
 }
@@ -147,7 +158,8 @@ int32_t RTC_close(int32_t fd) {
 
 /* 
  * RTC_read
- *   DESCRIPTION: Blocks until the next interrupt (at correct frequency).
+ *   DESCRIPTION: Blocks until the next interrupt (at correct frequency). The process sleeps on the RTC wait queue
+ *                instead of spinning, so the scheduler hands its time to other processes.
  *   INPUTS: fd -- file descriptor
              buffer -- pointer to buffer
              nbytes -- number of bytes
@@ -157,14 +169,22 @@ int32_t RTC_close(int32_t fd) {
  */
 int32_t RTC_read(int32_t fd, void* buffer, int32_t nbytes) {
 
-    RTC_counter[curr_terminal] = RTC_max_counter[curr_terminal]; //set counter to max (start value)
-    RTC_block[curr_terminal] = 1; // initialize block to 1
+    pcb_t* pcb;
 
-    while (1){
-        if (RTC_block[curr_terminal] == 0){ //once counter hits 0 block becomes 0 and we can return from read
-            break;
+    cli();
+    if (curr_pid == NO_PID) {
+        /* No process to block, sleep_on just waits for an interrupt until the kernel's tick has passed. */
+        kernel_rtc_counter = kernel_rtc_max_counter;
+        while (kernel_rtc_counter > 0) {
+            sleep_on(&RTC_wait_queue);
+            cli();
         }
+        sti();
+        return 0;
     }
+    pcb = get_pcb(curr_pid);
+    pcb->rtc_counter = pcb->rtc_max_counter; //set counter to max (start value)
+    sleep_on(&RTC_wait_queue); // RTC_handler wakes us once the counter hits 0
     return 0;
 }
 
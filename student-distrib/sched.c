@@ -0,0 +1,342 @@
+/* Multilevel feedback run queues, process blocking and wakeup. The scheduler itself lives in pit.c. */
+
+#include "sched.h"
+#include "syscalls.h"
+#include "pit.h"
+
+int32_t curr_pid = NO_PID;
+run_queue_t run_queues[SCHED_LEVELS];
+
+/* Time slice of a level in PIT input clocks */
+#define SCHED_SLICE(level)  (SCHED_QUANTUM(level) * PIT_TICK_COUNT)
+
+/* PIT input clocks of CPU time left until every process is moved back up to its base level */
+static int32_t boost_countdown = SCHED_BOOST_TICKS * PIT_TICK_COUNT;
+
+/* rdtsc when the running process was last armed or charged, the start of the time sched_charge adds to
+ * sched_busy_cycles. */
+static uint32_t run_start;
+
+/* 
+ * init_sched
+ *   DESCRIPTION: Empties the run queues. Nothing is running until the first shell is executed.
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: none
+ */
+void init_sched() {
+    int32_t level;
+
+    curr_pid = NO_PID;
+    for (level = 0; level < SCHED_LEVELS; level++) {
+        run_queues[level].head = NO_PID;
+        run_queues[level].tail = NO_PID;
+    }
+    boost_countdown = SCHED_BOOST_TICKS * PIT_TICK_COUNT;
+}
+
+/* 
+ * sched_set_level
+ *   DESCRIPTION: Moves a process to a priority level and gives it that level's full time slice.
+ *   INPUTS: pid -- the process to move
+ *           level -- SCHED_TOP_LEVEL through SCHED_BOTTOM_LEVEL
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: Only takes effect on the run queues the next time the process is made runnable.
+ */
+void sched_set_level(int32_t pid, int32_t level) {
+    pcb_t* pcb = get_pcb(pid);
+
+    pcb->priority = level;
+    pcb->slice_left = SCHED_SLICE(level);
+}
+
+/* 
+ * make_runnable
+ *   DESCRIPTION: Marks a process runnable and appends it to the run queue of its level in O(1).
+ *   INPUTS: pid -- the process to queue
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: Call with interrupts off. If the process outranks the one running, the PIT is set to go off
+ *                 right away so pit_handler preempts it.
+ */
+void make_runnable(int32_t pid) {
+    pcb_t* pcb = get_pcb(pid);
+    run_queue_t* queue = &run_queues[pcb->priority];
+
+    if (curr_pid != NO_PID && get_pcb(curr_pid)->state == PROCESS_RUNNING
+            && pcb->priority < get_pcb(curr_pid)->priority) {
+        sched_charge();
+        pit_one_shot(PIT_KICK_COUNT);
+    }
+
+    pcb->state = PROCESS_RUNNABLE;
+    pcb->run_next = NO_PID;
+    if (queue->tail == NO_PID) {
+        queue->head = pid;
+    } else {
+        get_pcb(queue->tail)->run_next = pid;
+    }
+    queue->tail = pid;
+}
+
+/* 
+ * pick_next_process
+ *   DESCRIPTION: Removes the process at the front of the highest-priority non-empty run queue.
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: the pid that should run next, or NO_PID if nothing is runnable
+ *   SIDE EFFECTS: Call with interrupts off.
+ */
+int32_t pick_next_process() {
+    int32_t level;
+    int32_t pid;
+
+    for (level = SCHED_TOP_LEVEL; level < SCHED_LEVELS; level++) {
+        pid = run_queues[level].head;
+        if (pid != NO_PID) {
+            run_queues[level].head = get_pcb(pid)->run_next;
+            if (run_queues[level].head == NO_PID) {
+                run_queues[level].tail = NO_PID;
+            }
+            return pid;
+        }
+    }
+    return NO_PID;
+}
+
+/* 
+ * sched_boost
+ *   DESCRIPTION: Moves every process back to its base level so CPU-bound processes that sank to the bottom
+ *                can't be starved, and a process that turned interactive gets its short slices back.
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: Rebuilds the run queues, keeping the order processes had within each level.
+ */
+static void sched_boost() {
+    run_queue_t old_queues[SCHED_LEVELS];
+    int32_t level;
+    int32_t pid;
+    int32_t next;
+    pcb_t* pcb;
+
+    for (level = 0; level < SCHED_LEVELS; level++) {
+        old_queues[level] = run_queues[level];
+        run_queues[level].head = NO_PID;
+        run_queues[level].tail = NO_PID;
+    }
+    for (level = 0; level < SCHED_LEVELS; level++) {
+        for (pid = old_queues[level].head; pid != NO_PID; pid = next) {
+            pcb = get_pcb(pid);
+            next = pcb->run_next;
+            sched_set_level(pid, pcb->base_priority);
+            make_runnable(pid);
+        }
+    }
+
+    // running and blocked processes aren't on a run queue, they requeue at the new level later
+    for (pid = 0; pid < NUM_PROCESSES; pid++) {
+        pcb = get_pcb(pid);
+        if (cur_processes[pid] && pcb->state != PROCESS_RUNNABLE) {
+            sched_set_level(pid, pcb->base_priority);
+        }
+    }
+}
+
+/* 
+ * sched_charge
+ *   DESCRIPTION: Stops the PIT and charges the running process for the time it has had the CPU, which also
+ *                counts as busy time in sched_busy_cycles. A process
+ *                that used up its slice drops a level; time spent blocked isn't refunded, so sleeping just
+ *                before the slice ends doesn't keep a process on top.
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: 1 if the running process used up its slice, 0 otherwise
+ *   SIDE EFFECTS: Call with interrupts off. The PIT stays stopped until sched_arm.
+ */
+int32_t sched_charge() {
+    uint32_t elapsed = pit_stop();
+    uint32_t now;
+    pcb_t* pcb;
+
+    if (curr_pid == NO_PID) {
+        return 0;
+    }
+    now = rdtsc();
+    sched_busy_cycles += now - run_start;
+    run_start = now;
+    pcb = get_pcb(curr_pid);
+    boost_countdown -= elapsed;
+    pcb->slice_left -= elapsed;
+    if (pcb->slice_left > 0) {
+        return 0;
+    }
+
+    if (pcb->priority < SCHED_BOTTOM_LEVEL) {
+        pcb->priority++;
+    }
+    pcb->slice_left = SCHED_SLICE(pcb->priority);
+    return 1;
+}
+
+/* 
+ * sched_arm
+ *   DESCRIPTION: Arms the PIT for whatever is left of the running process's slice, or for one tick if console
+ *                output is waiting to be flushed to the screen.
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: Call with interrupts off, after curr_pid is switched.
+ */
+void sched_arm() {
+    int32_t count;
+
+    if (curr_pid != NO_PID) {
+        run_start = rdtsc();
+        count = get_pcb(curr_pid)->slice_left;
+        if (count > PIT_TICK_COUNT && console_dirty()) {
+            count = PIT_TICK_COUNT;
+        }
+        pit_one_shot(count);
+    }
+}
+
+/* 
+ * sched_tick
+ *   DESCRIPTION: Called when the PIT goes off while a process is running. Decides whether it keeps the CPU.
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   RETURN VALUE: 1 if the running process should be switched out, 0 if it keeps the CPU
+ *   SIDE EFFECTS: Call with interrupts off and a process running. Rearms the PIT if the process keeps the CPU.
+ */
+int32_t sched_tick() {
+    pcb_t* pcb = get_pcb(curr_pid);
+    int32_t level;
+
+    if (sched_charge()) {
+        return 1;
+    }
+
+    if (boost_countdown <= 0) {
+        boost_countdown = SCHED_BOOST_TICKS * PIT_TICK_COUNT;
+        sched_boost();
+        return 1;
+    }
+
+    // a higher-priority process woke up in the middle of our slice
+    for (level = SCHED_TOP_LEVEL; level < pcb->priority; level++) {
+        if (run_queues[level].head != NO_PID) {
+            return 1;
+        }
+    }
+
+    sched_arm();
+    return 0;
+}
+
+/* 
+ * init_wait_queue
+ *   DESCRIPTION: Empties a wait queue.
+ *   INPUTS: queue -- the wait queue to initialize
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: none
+ */
+void init_wait_queue(wait_queue_t* queue) {
+    queue->head = NO_PID;
+    queue->interactive = 0;
+}
+
+/* 
+ * init_interactive_wait_queue
+ *   DESCRIPTION: Empties a wait queue for processes waiting on the user, like terminal_read. Whoever is woken
+ *                from it goes back to its base priority level, so the shell stays responsive.
+ *   INPUTS: queue -- the wait queue to initialize
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: none
+ */
+void init_interactive_wait_queue(wait_queue_t* queue) {
+    queue->head = NO_PID;
+    queue->interactive = 1;
+}
+
+/* 
+ * sleep_on
+ *   DESCRIPTION: Marks the current process as blocked, puts it on the wait queue, and switches to another process.
+ *                Must be called with interrupts off so a wakeup can't slip in between the caller's check and the sleep.
+ *   INPUTS: queue -- the wait queue to block on
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: Returns once the process has been woken and scheduled again, with interrupts enabled.
+ */
+void sleep_on(wait_queue_t* queue) {
+    int32_t pid = curr_pid;
+    pcb_t* pcb;
+
+    /* No process has been started yet (kernel tests at boot): just wait for the next interrupt. */
+    if (pid == NO_PID) {
+        asm volatile("sti; hlt" : : : "memory");
+        return;
+    }
+
+    pcb = get_pcb(pid);
+    pcb->state = PROCESS_BLOCKED;
+    pcb->wait_next = queue->head;
+    queue->head = pid;
+
+    // the scheduler skips us until someone wakes us up
+    scheduler();
+}
+
+/* 
+ * wake_up
+ *   DESCRIPTION: Makes every process on a wait queue runnable again.
+ *   INPUTS: queue -- the wait queue to empty
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: Processes join the back of the run queue for their level.
+ */
+void wake_up(wait_queue_t* queue) {
+    pcb_t* pcb;
+
+    while (queue->head != NO_PID) {
+        pcb = get_pcb(queue->head);
+        queue->head = pcb->wait_next;
+        pcb->wait_next = NO_PID;
+        if (queue->interactive) {
+            sched_set_level(pcb->pid, pcb->base_priority);
+        }
+        make_runnable(pcb->pid);
+    }
+}
+
+/* 
+ * wake_process
+ *   DESCRIPTION: Removes one process from a wait queue and makes it runnable again.
+ *   INPUTS: queue -- the wait queue the process is blocked on
+ *           pid -- the process to wake
+ *   OUTPUTS: none
+ *   RETURN VALUE: none
+ *   SIDE EFFECTS: Does nothing if the process is not on the queue.
+ */
+void wake_process(wait_queue_t* queue, int32_t pid) {
+    int32_t* link = &queue->head; // the link that points at the pid we are looking at
+    pcb_t* pcb;
+
+    while (*link != NO_PID) {
+        pcb = get_pcb(*link);
+        if (*link == pid) {
+            *link = pcb->wait_next;
+            pcb->wait_next = NO_PID;
+            if (queue->interactive) {
+                sched_set_level(pid, pcb->base_priority);
+            }
+            make_runnable(pid);
+            return;
+        }
+        link = &pcb->wait_next;
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef _SCHED_H_
+#define _SCHED_H_
+
+#include "types.h"
+
+/* Process states kept in pcb_t.state */
+#define PROCESS_RUNNING     0   /* on the CPU right now (curr_pid) */
+#define PROCESS_RUNNABLE    1   /* waiting its turn on the run queue */
+#define PROCESS_BLOCKED     2   /* waiting on a wait queue or for a child, not on the run queue */
+#define PROCESS_ZOMBIE      3   /* halted, its pid is being released */
+
+/* Marks the end of a run queue or wait queue */
+#define NO_PID  -1
+
+/* Multilevel feedback queue. Level 0 runs first and gets the shortest time slice; a process that uses up
+ * its slice drops a level, so CPU-bound programs sink while ones that block on input stay near the top. */
+#define SCHED_LEVELS        3
+#define SCHED_TOP_LEVEL     0
+#define SCHED_BOTTOM_LEVEL  (SCHED_LEVELS - 1)
+#define SCHED_QUANTUM(level)    (1 << (level))  /* PIT ticks per slice: 1, 2, 4 */
+#define SCHED_BOOST_TICKS   100                 /* every second of CPU time everyone goes back to their base level */
+
+/* The process currently on the CPU, NO_PID before the first shell starts */
+extern int32_t curr_pid;
+
+/* FIFO of runnable pids, linked through pcb_t.run_next. There is one per priority level. */
+typedef struct run_queue {
+    int32_t head;
+    int32_t tail;
+} run_queue_t;
+
+/* A wait queue is a list of blocked pids, linked through pcb_t.wait_next. */
+typedef struct wait_queue {
+    int32_t head;
+    int32_t interactive; /* processes woken from here go back to their base level with a fresh slice */
+} wait_queue_t;
+
+/* Empties the run queues */
+void init_sched();
+
+/* Puts a new process at a priority level with a full time slice */
+void sched_set_level(int32_t pid, int32_t level);
+
+/* Marks a process runnable and adds it to the back of the run queue for its level */
+void make_runnable(int32_t pid);
+
+/* Takes the process at the front of the highest non-empty run queue, NO_PID if they are all empty */
+int32_t pick_next_process();
+
+/* Stops the PIT and charges the running process for its CPU time, returns 1 if its slice ran out */
+int32_t sched_charge();
+
+/* Arms the PIT for the rest of the running process's slice */
+void sched_arm();
+
+/* Handles the PIT going off while a process runs, returns 1 if it should give up the CPU */
+int32_t sched_tick();
+
+/* Empties a wait queue */
+void init_wait_queue(wait_queue_t* queue);
+
+/* Empties a wait queue whose sleepers are waiting on the user */
+void init_interactive_wait_queue(wait_queue_t* queue);
+
+/* Blocks the current process on a wait queue and gives up the CPU. Call with interrupts off. */
+void sleep_on(wait_queue_t* queue);
+
+/* Wakes every process on a wait queue */
+void wake_up(wait_queue_t* queue);
+
+/* Wakes a single process and removes it from the wait queue it is blocked on */
+void wake_process(wait_queue_t* queue, int32_t pid);
+
+#endif
@@ -6,8 +6,12 @@
 #include "x86_desc.h"
 #include "terminal.h"
 #include "pit.h"
+#include "frame.h"
+#include "syscalls_linkage.h"
+#include "pipe.h"
 
-int cur_processes[NUM_PROCESSES] = {0,0,0,0,0,0}; // cur_processes keeps track of current processes that are running
+int cur_processes[NUM_PROCESSES] = {0}; // cur_processes keeps track of current processes that are running
+int share_program_pages = 1; // map whole program pages straight from the file system image instead of copying them
 
 
 /* init_fops_table()
@@ -45,29 +49,39 @@ void init_fops_table() {
     file_ops.close = &close_file;
     file_ops.read = &read_file;
     file_ops.write = &write_file;
+
+    // Initializing pipe functions, the read end and the write end each only go one way
+    pipe_read_ops.open = NULL;
+    pipe_read_ops.close = &pipe_close;
+    pipe_read_ops.read = &pipe_read;
+    pipe_read_ops.write = &pipe_read_end_write;
+
+    pipe_write_ops.open = NULL;
+    pipe_write_ops.close = &pipe_close;
+    pipe_write_ops.read = &pipe_write_end_read;
+    pipe_write_ops.write = &pipe_write;
 }
 
-/* system_execute(const uint8_t* command)
+/* system_spawn(const uint8_t* command)
  * Inputs: const uint8_t* command: command inputted that we want to exceute if valid
- * Return Value: 0 (should never reach here), -1 (failure)
- * Function: Parses args, makes sure file is valid, sets up paging
- * for the process, and loads file into memory, creates PCB struct instance,
- * opens and initiliazes file descriptor array, 
- * prepares stack and context switch values, IRET
+ * Return Value: pid of the new process, -1 (failure)
+ * Function: Parses args, makes sure file is valid, reads the program headers,
+ * creates PCB struct instance, opens and initiliazes file descriptor array,
+ * and prepares a kernel stack that irets to the program's entry point the first
+ * time the scheduler picks the process. The caller keeps running.
  */
-int32_t system_execute(const uint8_t* command) {
-    cli(); // clear interrupts
+int32_t system_spawn(const uint8_t* command) {
     int8_t elf_check[ELF_LENGTH]; // holds ELF that we want to compare with
     uint8_t filename[FILENAME_LEN + 1]; // holds name of executable we want to execute
     int8_t buf[ELF_LENGTH]; // holds info
-    uint32_t pid; // process ID
+    int32_t pid; // process ID
     int arg_idx = 0; // start of arguments
-    uint32_t temp_esp;
-    uint32_t temp_ebp;
-    char* cur_args = ""; // keeps track of current arguments inputted
+    char cur_args[MAX_ARGS_LEN]; // keeps track of current arguments inputted
+    uint32_t flags;
+    uint32_t eip;
+    uint32_t* stack;
 
     if (command == NULL) {
-        sti();
         return -1;
     }
     int i; // looping variable
@@ -86,7 +100,7 @@ int32_t system_execute(const uint8_t* command) {
         i++;
     }
     // Get the name of the executable
-    while (command[i] != '\0' && i < FILENAME_LEN) {
+    while (command[i] != '\0' && file_index < FILENAME_LEN) {
         if (command[i] == ' ') {
             arg_idx = i + 1; //where the first arg potentially is
             while (command[arg_idx] == ' ') { //skipping spaces between executable name and first arg
@@ -106,8 +120,8 @@ int32_t system_execute(const uint8_t* command) {
     // two variables we will be using to check for spaces at the end of the argument
     int temp_idx;
     int space_flag;
-    // Get arguments and putting it into global buffer
-    while(arg_idx != 0 && arg_idx < strlen((int8_t*) command) && command[arg_idx] != '\0') {
+    // Get arguments and putting it into the local buffer
+    while(arg_idx != 0 && command[arg_idx] != '\0' && i < MAX_ARGS_LEN - 1) {
         if (command[arg_idx] == ' ') {
             space_flag = 0; // space_flag being set to 0 means we are currently iterating through useless spaces at the end
             temp_idx = arg_idx; // temporary index since arg_idx needs to be saved for later
@@ -134,38 +148,31 @@ int32_t system_execute(const uint8_t* command) {
     dentry_t dentry;
     // Check the validity of the filename
     if (read_dentry_by_name(filename, &dentry) == -1) {
-        sti();
         return -1;
     }
 
     // Check ELF magic constant
     read_data(dentry.inode_num, 0, (uint8_t *) buf, ELF_LENGTH);
     if (strncmp(elf_check, buf, ELF_LENGTH) != 0) {
-        sti();
         return -1;
     }
 
     /*--------------------------------------------------------------------------------------------------*/
 
+    cli_and_save(flags);
+
     // Find free PID location
-    for (i = 0; i <= NUM_PROCESSES; i++) {
-        if (i == NUM_PROCESSES) {
-            sti();
-            return -1; // no available space for new process
-        }
-        else if (cur_processes[i] == 0) { // not in use process
-            cur_processes[i] = 1;  // set to in use
-            pid = i; // set pid
-            break;
-        }
+    if ((pid = alloc_pid()) == -1) {
+        restore_flags(flags);
+        return -1; // no available space for new process
     }
 
-    // Set up paging and flush TLB
-    process_page(pid);
-    flushTLB();
-
-    // User-level program loader
-    read_data(dentry.inode_num, 0, (uint8_t *) VIRTUAL_ADDR, FOUR_MB);
+    // User-level program loader, pages are only loaded once the program touches them
+    if (load_program(dentry.inode_num, pid) == -1) {
+        cur_processes[pid] = 0;
+        restore_flags(flags);
+        return -1;
+    }
 
     // Create PCB
     pcb_t *pcb = get_pcb(pid);
@@ -173,127 +180,199 @@ int32_t system_execute(const uint8_t* command) {
     // Initialize PCB's pid
     pcb->pid = pid;
     // store pcb's arguments
-    pcb->args = cur_args;
+    strcpy(pcb->args, cur_args);
+    // new processes wait on the run queue with the RTC at its default virtual rate
+    pcb->wait_next = NO_PID;
+    pcb->run_next = NO_PID;
+    pcb->rtc_max_counter = rtc_max_usable_frequency / rtc_min_frequency;
+    pcb->rtc_counter = pcb->rtc_max_counter;
+    pcb->exit_status = 0;
+    init_wait_queue(&pcb->child_exit_queue);
+    memset(pcb->mmaps, 0, sizeof(pcb->mmaps));
+    pcb->vidmapped = 0;
 
     // Check if base shell of the terminal it's on
     if (base_shell == 1) {
         pcb->parent_pid = BASE_SHELL;
-        terminal_array[curr_terminal].pid = pid;
         pcb->terminal_id = curr_terminal;
+        pcb->base_priority = SCHED_TOP_LEVEL;
     }
     else {
-        // Set parent pcb to the pid in the terminal_array
-        pcb->parent_pid = terminal_array[screen_terminal].pid;
-        parent_pcb = get_pcb(terminal_array[screen_terminal].pid);
-
-            /* Getting the ebp and esp of the current terminal. */
-         asm volatile("                     \n\
-            movl %%ebp, %0               \n\
-            movl %%esp, %1               \n\
-            "
-            : "=r" (temp_ebp), "=r" (temp_esp)
-            :
-            : "eax"
-            );
-
-        /* Storing the ebp and esp of the current terminal onto the stack. */
-        parent_pcb->ebp = temp_ebp;
-        parent_pcb->esp = temp_esp;
-        terminal_array[screen_terminal].pid = pid;
-        pcb->terminal_id = screen_terminal;
+        // The parent is the process making this call, it runs on the same terminal
+        pcb->parent_pid = curr_pid;
+        parent_pcb = get_pcb(curr_pid);
+        pcb->terminal_id = parent_pcb->terminal_id;
+        // children inherit the parent's set_priority level
+        pcb->base_priority = parent_pcb->base_priority;
     }
+    sched_set_level(pid, pcb->base_priority);
 
     base_shell = 0;    
 
-    // Initializing stdin
-    pcb->file_descriptors[0].file_op_table_ptr = &term_read_ops;
-    pcb->file_descriptors[0].inode = 0;
-    pcb->file_descriptors[0].file_pos = 0;
-    pcb->file_descriptors[0].flags = IN_USE;
+    if (pcb->parent_pid == BASE_SHELL) {
+        // Initializing stdin
+        pcb->file_descriptors[0].file_op_table_ptr = &term_read_ops;
+        pcb->file_descriptors[0].inode = 0;
+        pcb->file_descriptors[0].file_pos = 0;
+        pcb->file_descriptors[0].flags = IN_USE;
 
-    // Initializing stdout
-    pcb->file_descriptors[1].file_op_table_ptr = &term_write_ops;
-    pcb->file_descriptors[1].inode = 0;
-    pcb->file_descriptors[1].file_pos = 0;
-    pcb->file_descriptors[1].flags = IN_USE;
+        // Initializing stdout
+        pcb->file_descriptors[1].file_op_table_ptr = &term_write_ops;
+        pcb->file_descriptors[1].inode = 0;
+        pcb->file_descriptors[1].file_pos = 0;
+        pcb->file_descriptors[1].flags = IN_USE;
+    }
+    else {
+        // stdin and stdout come from the parent, so they can be the ends of a pipe
+        for (i = 0; i < FILE_DESCRIPTOR_MIN; i++) {
+            pcb->file_descriptors[i] = parent_pcb->file_descriptors[i];
+            pipe_ref(&pcb->file_descriptors[i]);
+        }
+    }
 
     // Initializing general use fd slots 
     for(i = FILE_DESCRIPTOR_MIN; i < FILE_DESCRIPTOR_MAX; i++) {
         pcb->file_descriptors[i].inode = 0;
         pcb->file_descriptors[i].file_pos = 0;
+        pcb->file_descriptors[i].cursor_block = NULL;
         pcb->file_descriptors[i].flags = NOT_IN_USE;
     }
 
-    // Initialize PCB's tss variables
-    pcb->tss_esp0 = tss.esp0;
-    pcb->tss_ss0 = tss.ss0;
-
-    // Context switch
-    tss.esp0 = EIGHT_MB - pid * EIGHT_KB;
-    tss.ss0 = KERNEL_DS;
-
     // Reads EIP (bytes 24-27)
-    uint32_t eip;
-    read_data(dentry.inode_num, 24, (uint8_t*)&eip, 4); // Magic numbers: 24 is the starting index, 4 is the length of bytes 24-27
+    read_data(dentry.inode_num, ELF_ENTRY, (uint8_t*)&eip, sizeof(eip));
 
     // Initialize PCB's eip
     pcb->eip = eip;
 
     // https://wiki.osdev.org/Getting_to_Ring_3
-    
-    update_tss(pid, curr_terminal); 
-
-    // IRET
-    // First line "0x02B is USER_DS"
-    // Setting up stack for IRET context switch
-    asm volatile("                                          \n\
-                movw $0x2B, %%ax # user ds                  \n\
-                movw %%ax, %%ds                             \n\
-                pushl %0                                    \n\
-                pushl %1                                    \n\
-                pushfl                                      \n\
-                popl %%eax                                  \n\
-                orl $0x200, %%eax   # enabling interrupts   \n\
-                pushl %%eax                                 \n\
-                pushl %2                                    \n\
-                pushl %3                                    \n\
-                "
-                :
-                : "r" (USER_DS), "r" (USER_ESP), "r" (USER_CS), "r" (eip)
-                : "eax"
-                );
-    asm volatile("iret");
-    asm volatile("                  \n\
-                execute_return:     \n\
-                leave               \n\
-                ret                 \n\
-                ");
 
-    return 0;
+    // IRET frame at the top of the new kernel stack, below it the return address for the scheduler's
+    // leave; ret and the ebp that leave pops
+    stack = (uint32_t*) (EIGHT_MB - pid * EIGHT_KB);
+    *--stack = USER_DS;
+    *--stack = USER_ESP;
+    *--stack = USER_EFLAGS;
+    *--stack = USER_CS;
+    *--stack = eip;
+    *--stack = (uint32_t) process_start;
+    *--stack = 0;
+    pcb->ebp = (uint32_t) stack;
+    pcb->esp = pcb->ebp - START_STACK_SLACK;
+
+    make_runnable(pid);
+    restore_flags(flags);
+    return pid;
+}
+
+/* system_execute(const uint8_t* command)
+ * Inputs: const uint8_t* command: command inputted that we want to exceute if valid
+ * Return Value: the program's exit status, -1 (failure)
+ * Function: Spawns the program and blocks until it halts.
+ */
+int32_t system_execute(const uint8_t* command) {
+    int32_t pid;
+    int32_t status;
+
+    if ((pid = system_spawn(command)) == -1) {
+        return -1;
+    }
+    if (wait_child(pid, &status, 0) == -1) {
+        return -1;
+    }
+    return status;
+}
+
+/* wait_child(int32_t pid, int32_t* status, int32_t options)
+ * Inputs: int32_t pid: child to wait for, WAIT_ANY for any child,
+ * int32_t* status: kernel pointer loaded with the child's exit status,
+ * int32_t options: WNOHANG to return right away if no child has halted yet
+ * Return Value: pid of the reaped child, 0 (WNOHANG and nothing to reap), -1 (no such child)
+ * Function: Sleeps on the caller's child_exit_queue until a matching child is a zombie,
+ * then frees its pid.
+ */
+int32_t wait_child(int32_t pid, int32_t* status, int32_t options) {
+    pcb_t *pcb = get_pcb(curr_pid);
+    pcb_t *child;
+    int32_t found;
+    int32_t i;
+
+    cli();
+    while (1) {
+        found = 0;
+        for (i = 0; i < NUM_PROCESSES; i++) {
+            child = get_pcb(i);
+            if (!cur_processes[i] || child->parent_pid != curr_pid || (pid != WAIT_ANY && pid != i)) {
+                continue;
+            }
+            found = 1;
+            if (child->state == PROCESS_ZOMBIE) {
+                *status = child->exit_status;
+                cur_processes[i] = 0;
+                sti();
+                return i;
+            }
+        }
+        if (!found || (options & WNOHANG)) {
+            sti();
+            return found ? 0 : -1;
+        }
+        // halt wakes us up when one of our children becomes a zombie
+        sleep_on(&pcb->child_exit_queue);
+        cli();
+    }
+}
+
+/* system_waitpid(int32_t pid, int32_t* status, int32_t options)
+ * Inputs: int32_t pid: child to wait for, WAIT_ANY (-1) for any child,
+ * int32_t* status: user pointer for the exit status, may be NULL,
+ * int32_t options: 0 or WNOHANG
+ * Return Value: pid of the reaped child, 0 (WNOHANG and nothing to reap), -1 (failure)
+ * Function: Collects the exit status of a child that has halted.
+ */
+int32_t system_waitpid(int32_t pid, int32_t* status, int32_t options) {
+    int32_t child_status;
+    int32_t child_pid;
+
+    if (status != NULL && ((uint32_t) status < ONE_TWENTY_EIGHT_MB || (uint32_t) status > USER_REGION_END - sizeof(int32_t))) {
+        return -1;
+    }
+    child_pid = wait_child(pid, &child_status, options);
+    // pid 0 is always the first base shell, nobody's child
+    if (child_pid > 0 && status != NULL) {
+        *status = child_status;
+    }
+    return child_pid;
+}
+
+/* system_wait(int32_t* status)
+ * Inputs: int32_t* status: user pointer for the exit status, may be NULL
+ * Return Value: pid of the reaped child, -1 (no children)
+ * Function: Blocks until any child halts.
+ */
+int32_t system_wait(int32_t* status) {
+    return system_waitpid(WAIT_ANY, status, 0);
 }
 
 /* system_halt(uint8_t status)
  * Inputs: uint8_t status: return value set by user program
  * Return Value: never actually returns a value
- * Function: Restores parent pcb data,
- * restores parent pcb paging, checks if currently running shell,
- * if so calls execute("shell") again, else closes all relevant FDs,
- * and jumpts to execute return.
+ * Function: Checks if currently running base shell, if so restarts it,
+ * else closes all relevant FDs, frees the user pages, and leaves a zombie
+ * for the parent to collect with waitpid before giving up the CPU for good.
  */
 int32_t system_halt(uint8_t status) {
     cli();
     int i; // looping variable
 
     // Get current and parent PCB
-    int halting_pid = terminal_array[curr_terminal].pid;
+    int halting_pid = curr_pid;
 
     pcb_t* pcb = get_pcb(halting_pid);
     uint32_t parent_pid = pcb->parent_pid;
-    pcb_t* parent_pcb = get_pcb(parent_pid);
-    uint32_t ext_status;
+    pcb_t* child;
 
     // If currently running base shell, reload
-    if (parent_pid == BASE_SHELL && terminal_array[curr_terminal].flag == 1) {
+    if (parent_pid == BASE_SHELL && terminal_array[pcb->terminal_id].flag == 1) {
         asm volatile("                                          \n\
                     cli                                         \n\
                     movw $0x2B, %%ax  # user ds                 \n\
@@ -315,48 +394,46 @@ int32_t system_halt(uint8_t status) {
         asm volatile("iret");
     }
 
-    // Update cur_processes
-    cur_processes[halting_pid] = 0;
-
-    // Set the curr_pid to the parent pid.
-    terminal_array[curr_terminal].pid = parent_pid;
-    
-    // Restore paging and flush TLB
-    process_page(parent_pid);
-    flushTLB();
-
-    // Close all file operations
+    // Close all file operations, stdin and stdout too in case they are pipes
     for (i = 0; i < FILE_DESCRIPTOR_MAX; i++) {
-        system_close(i);
+        close_fd(i);
     }
 
-    // Restoring tss
-    tss.esp0 = EIGHT_MB - parent_pid * EIGHT_KB;
-    tss.ss0 = KERNEL_DS;
+    // Nothing touches user memory from here on, the scheduler switches page tables
+    free_user_pages(halting_pid);
+    if (pcb->vidmapped) {
+        console_vidmap_release(pcb->terminal_id);
+    }
 
     if(status == EXCEPTION) { // accounting for status being 8 bits
-        ext_status = EXCEPTION+1;
+        pcb->exit_status = EXCEPTION+1;
     }
     else{
-        ext_status = status;
+        pcb->exit_status = status;
+    }
+
+    // Our zombie children are nobody's to collect any more, the rest free themselves when they halt
+    for (i = 0; i < NUM_PROCESSES; i++) {
+        child = get_pcb(i);
+        if (cur_processes[i] && i != halting_pid && child->parent_pid == halting_pid) {
+            if (child->state == PROCESS_ZOMBIE) {
+                cur_processes[i] = 0;
+            } else {
+                child->parent_pid = NO_PARENT;
+            }
+        }
     }
 
-    update_tss(parent_pid, curr_terminal);
-    terminal_array[curr_terminal].pid = parent_pid;
+    pcb->state = PROCESS_ZOMBIE;
+    if (parent_pid < NUM_PROCESSES) {
+        // The parent collects our status
+        wake_up(&get_pcb(parent_pid)->child_exit_queue);
+    } else {
+        cur_processes[halting_pid] = 0;
+    }
 
-    sti();
-    // Assembly to load old esp, ebp, and status 
-    asm volatile("                           \n\
-                movl %0, %%eax               \n\
-                movl %1, %%esp               \n\
-                movl %2, %%ebp               \n\
-                jmp execute_return           \n\
-                "
-                :
-                : "r" (ext_status), "r" (parent_pcb->esp), "r" (parent_pcb->ebp)
-                : "eax"
-                );
-    // Will never reach here
+    // The scheduler never comes back to a zombie
+    scheduler();
     return 0;
 }
 
@@ -369,8 +446,9 @@ int32_t system_halt(uint8_t status) {
  * if so we call the corresponding read.
  */
 int32_t system_read (int32_t fd, void* buf, int32_t nbytes) {
-    pcb_t *pcb = get_pcb(terminal_array[curr_terminal].pid); // getting current pcb pointer
-    if((fd >= 0 && fd < FILE_DESCRIPTOR_MAX && fd != 1) && pcb->file_descriptors[fd].flags != NOT_IN_USE) { 
+    pcb_t *pcb = get_pcb(curr_pid); // getting current pcb pointer
+    if((fd >= 0 && fd < FILE_DESCRIPTOR_MAX && fd != 1) && pcb->file_descriptors[fd].flags != NOT_IN_USE
+        && pcb->file_descriptors[fd].file_op_table_ptr->read != NULL) { 
         return pcb->file_descriptors[fd].file_op_table_ptr->read(fd, buf, nbytes); // returning respective read
     }
     else{
@@ -387,8 +465,9 @@ int32_t system_read (int32_t fd, void* buf, int32_t nbytes) {
  * if so we call the corresponding write.
  */
 int32_t system_write (int32_t fd, const void* buf, int32_t nbytes) {
-    pcb_t *pcb = get_pcb(terminal_array[curr_terminal].pid); // getting current pcb pointer
-    if((fd >= 1 && fd < FILE_DESCRIPTOR_MAX) && pcb->file_descriptors[fd].flags != NOT_IN_USE) { 
+    pcb_t *pcb = get_pcb(curr_pid); // getting current pcb pointer
+    if((fd >= 1 && fd < FILE_DESCRIPTOR_MAX) && pcb->file_descriptors[fd].flags != NOT_IN_USE
+        && pcb->file_descriptors[fd].file_op_table_ptr->write != NULL) { 
         return pcb->file_descriptors[fd].file_op_table_ptr->write(fd, buf, nbytes); // returning respective write
     }
     else{
@@ -407,7 +486,7 @@ int32_t system_open (const uint8_t* filename) {
     uint32_t file_type;
     int i;
     int index = -1;
-    pcb_t *pcb = get_pcb(terminal_array[curr_terminal].pid); // getting current pcb pointer
+    pcb_t *pcb = get_pcb(curr_pid); // getting current pcb pointer
     for(i = FILE_DESCRIPTOR_MIN; i < FILE_DESCRIPTOR_MAX; i++) { // finding first open file descriptor
         if(pcb->file_descriptors[i].flags == NOT_IN_USE) {
             index = i; // setting index of  open fd
@@ -420,6 +499,7 @@ int32_t system_open (const uint8_t* filename) {
         pcb->file_descriptors[index].flags = IN_USE; // marking as in use
         pcb->file_descriptors[index].inode = temp_dentry.inode_num; // setting to correct inode
         pcb->file_descriptors[index].file_pos = 0; // initializing position to 0
+        pcb->file_descriptors[index].cursor_block = NULL; // the first read looks up its data block
 
         switch (file_type)
         {
@@ -453,18 +533,249 @@ int32_t system_open (const uint8_t* filename) {
  * if so we call the corresponding close.
  */
 int32_t system_close (int32_t fd) {
-    pcb_t *pcb = get_pcb(terminal_array[curr_terminal].pid);
-    // Check if fd is valid index and if fd is in use
-    if ((fd >= FILE_DESCRIPTOR_MIN && fd < FILE_DESCRIPTOR_MAX) && pcb->file_descriptors[fd].flags != NOT_IN_USE) { 
-        pcb->file_descriptors[fd].flags = NOT_IN_USE; // marking as not in use
-        pcb->file_descriptors[fd].inode = -1; // marking as not pointing to any inode
-        pcb->file_descriptors[fd].file_pos = 0; // file position reset to 0 
-        return pcb->file_descriptors[fd].file_op_table_ptr->close(fd);
+    // Check if fd is valid index, stdin and stdout stay open
+    if (fd >= FILE_DESCRIPTOR_MIN && fd < FILE_DESCRIPTOR_MAX) { 
+        return close_fd(fd);
     } else {
         return -1;
     }
 }
 
+/* close_fd(int32_t fd)
+ * Inputs: int32_t fd: file descriptor index, stdin and stdout included.
+ * Return Value: Close function result, -1 ("failure")
+ * Function: Calls the descriptor's close while it is still filled in, then frees the slot.
+ */
+int32_t close_fd(int32_t fd) {
+    pcb_t *pcb = get_pcb(curr_pid);
+    fd_t *file = &pcb->file_descriptors[fd];
+    int32_t ret = 0;
+
+    if (file->flags == NOT_IN_USE) {
+        return -1;
+    }
+    if (file->file_op_table_ptr->close != NULL) {
+        ret = file->file_op_table_ptr->close(fd);
+    }
+    file->flags = NOT_IN_USE; // marking as not in use
+    file->inode = -1; // marking as not pointing to any inode
+    file->file_pos = 0; // file position reset to 0 
+    file->cursor_block = NULL;
+    return ret;
+}
+
+/* system_dup2(int32_t oldfd, int32_t newfd)
+ * Inputs: int32_t oldfd: open file descriptor to copy,
+ * int32_t newfd: slot to copy it into, closed first if it is open.
+ * Return Value: newfd, -1 ("failure")
+ * Function: Makes newfd refer to the same file as oldfd. The shell uses it to put
+ * the ends of a pipe on stdin and stdout before running a command.
+ */
+int32_t system_dup2(int32_t oldfd, int32_t newfd) {
+    pcb_t *pcb = get_pcb(curr_pid);
+
+    if (oldfd < 0 || oldfd >= FILE_DESCRIPTOR_MAX || newfd < 0 || newfd >= FILE_DESCRIPTOR_MAX
+        || pcb->file_descriptors[oldfd].flags == NOT_IN_USE) {
+        return -1;
+    }
+    if (oldfd == newfd) {
+        return newfd;
+    }
+    close_fd(newfd);
+    pcb->file_descriptors[newfd] = pcb->file_descriptors[oldfd];
+    pipe_ref(&pcb->file_descriptors[newfd]);
+    return newfd;
+}
+
+/* system_create(const uint8_t* filename)
+ * Inputs: const uint8_t* filename: name of the file to create
+ * Return Value: 0 ("success"), -1 ("failure")
+ * Function: Adds an empty regular file, which can then be opened and written.
+ */
+int32_t system_create(const uint8_t* filename) {
+    return fs_create(filename);
+}
+
+/* system_unlink(const uint8_t* filename)
+ * Inputs: const uint8_t* filename: name of the file to remove
+ * Return Value: 0 ("success"), -1 ("failure")
+ * Function: Removes a regular file and frees its blocks, unless a process has it open or is running it.
+ */
+int32_t system_unlink(const uint8_t* filename) {
+    dentry_t dentry;
+    pcb_t *pcb;
+    uint32_t flags;
+    int32_t ret;
+    int i, j;
+
+    cli_and_save(flags);
+    if (read_dentry_by_name(filename, &dentry) == -1 || dentry.filetype != REGULAR_FILE || inode_mapped(dentry.inode_num)) {
+        restore_flags(flags);
+        return -1;
+    }
+    for (i = 0; i < NUM_PROCESSES; i++) {
+        pcb = get_pcb(i);
+        if (!cur_processes[i] || pcb->state == PROCESS_ZOMBIE) {
+            continue;
+        }
+        for (j = 0; j < FILE_DESCRIPTOR_MAX; j++) { // dup2 can put a file on stdin or stdout
+            if (pcb->file_descriptors[j].flags != NOT_IN_USE && pcb->file_descriptors[j].file_op_table_ptr == &file_ops &&
+                pcb->file_descriptors[j].inode == dentry.inode_num) {
+                restore_flags(flags);
+                return -1;
+            }
+        }
+    }
+    ret = fs_unlink(filename);
+    restore_flags(flags);
+    return ret;
+}
+
+/* system_getdents(int32_t fd, void* buf, int32_t nbytes)
+ * Inputs: int32_t fd: file descriptor index of an open directory,
+ * void* buf: user buffer for dirent_t records,
+ * int32_t nbytes: size of buf.
+ * Return Value: bytes of records read, 0 at the end of the directory, -1 ("failure")
+ * Function: Reads as many directory entries as fit in buf with a single system call.
+ */
+int32_t system_getdents(int32_t fd, void* buf, int32_t nbytes) {
+    pcb_t *pcb = get_pcb(curr_pid);
+
+    if (fd < 0 || fd >= FILE_DESCRIPTOR_MAX || pcb->file_descriptors[fd].flags == NOT_IN_USE ||
+        pcb->file_descriptors[fd].file_op_table_ptr != &dir_ops) {
+        return -1;
+    }
+    if (buf == NULL || nbytes < 0 || (uint32_t) buf < ONE_TWENTY_EIGHT_MB || (uint32_t) buf > USER_REGION_END ||
+        (uint32_t) nbytes > USER_REGION_END - (uint32_t) buf) {
+        return -1;
+    }
+    return getdents_directory(fd, (dirent_t*) buf, nbytes);
+}
+
+/* system_stat(const uint8_t* filename, void* buf)
+ * Inputs: const uint8_t* filename: name of a file,
+ * void* buf: user stat_t buffer for the file's type, inode number and length.
+ * Return Value: 0 ("success"), -1 ("failure")
+ * Function: Looks up a file's metadata without opening or reading it.
+ */
+int32_t system_stat(const uint8_t* filename, void* buf) {
+    dentry_t dentry;
+
+    if (buf == NULL || (uint32_t) buf < ONE_TWENTY_EIGHT_MB || (uint32_t) buf > USER_REGION_END - sizeof(stat_t)) {
+        return -1;
+    }
+    if (read_dentry_by_name(filename, &dentry) == -1) {
+        return -1;
+    }
+    stat_dentry(&dentry, (stat_t*) buf);
+    return 0;
+}
+
+/* system_fstat(int32_t fd, void* buf)
+ * Inputs: int32_t fd: file descriptor index, stdin and stdout included,
+ * void* buf: user stat_t buffer for the file's type, inode number and length.
+ * Return Value: 0 ("success"), -1 ("failure")
+ * Function: Tells what an open fd refers to: a regular file and its current length, the directory,
+ * the RTC, the terminal, or a pipe and how many bytes are waiting in it.
+ */
+int32_t system_fstat(int32_t fd, void* buf) {
+    pcb_t *pcb = get_pcb(curr_pid);
+    stat_t *info = (stat_t*) buf;
+    fd_t *file;
+    dentry_t dentry;
+
+    if (buf == NULL || (uint32_t) buf < ONE_TWENTY_EIGHT_MB || (uint32_t) buf > USER_REGION_END - sizeof(stat_t)) {
+        return -1;
+    }
+    if (fd < 0 || fd >= FILE_DESCRIPTOR_MAX || pcb->file_descriptors[fd].flags == NOT_IN_USE) {
+        return -1;
+    }
+    file = &pcb->file_descriptors[fd];
+
+    info->inode_num = 0;
+    info->length = 0;
+    if (file->file_op_table_ptr == &file_ops) {
+        dentry.filetype = REGULAR_FILE;
+        dentry.inode_num = file->inode;
+        stat_dentry(&dentry, info);
+    } else if (file->file_op_table_ptr == &dir_ops) {
+        info->filetype = DIRECTORY_FILE;
+    } else if (file->file_op_table_ptr == &rtc_ops) {
+        info->filetype = RTC_FILE;
+    } else if (file->file_op_table_ptr == &pipe_read_ops || file->file_op_table_ptr == &pipe_write_ops) {
+        info->filetype = PIPE_FILE;
+        info->length = pipe_buffered(file);
+    } else {
+        info->filetype = TERMINAL_FILE;
+    }
+    return 0;
+}
+
+/* system_lseek(int32_t fd, int32_t offset, int32_t whence)
+ * Inputs: int32_t fd: file descriptor index of an open regular file,
+ * int32_t offset: bytes to move the file position by,
+ * int32_t whence: SEEK_SET, SEEK_CUR or SEEK_END.
+ * Return Value: the new file position, -1 ("failure")
+ * Function: Moves where the next read or write on the fd starts.
+ */
+int32_t system_lseek(int32_t fd, int32_t offset, int32_t whence) {
+    pcb_t *pcb = get_pcb(curr_pid);
+
+    if (fd < 0 || fd >= FILE_DESCRIPTOR_MAX || pcb->file_descriptors[fd].flags == NOT_IN_USE ||
+        pcb->file_descriptors[fd].file_op_table_ptr != &file_ops) {
+        return -1;
+    }
+    return lseek_file(fd, offset, whence);
+}
+
+/* system_pread(int32_t fd, void* buf, int32_t nbytes, int32_t offset)
+ * Inputs: int32_t fd: file descriptor index of an open regular file,
+ * void* buf: user buffer for the data,
+ * int32_t nbytes: number of bytes to read,
+ * int32_t offset: where in the file to read from.
+ * Return Value: number of bytes read, -1 ("failure")
+ * Function: Reads at an offset without moving the fd's file position.
+ */
+int32_t system_pread(int32_t fd, void* buf, int32_t nbytes, int32_t offset) {
+    pcb_t *pcb = get_pcb(curr_pid);
+
+    if (fd < 0 || fd >= FILE_DESCRIPTOR_MAX || pcb->file_descriptors[fd].flags == NOT_IN_USE ||
+        pcb->file_descriptors[fd].file_op_table_ptr != &file_ops) {
+        return -1;
+    }
+    if (buf == NULL || nbytes < 0 || (uint32_t) buf < ONE_TWENTY_EIGHT_MB || (uint32_t) buf > USER_REGION_END ||
+        (uint32_t) nbytes > USER_REGION_END - (uint32_t) buf) {
+        return -1;
+    }
+    return pread_file(fd, buf, nbytes, offset);
+}
+
+/* inode_mapped(uint32_t inode)
+ * Inputs: uint32_t inode: inode of a regular file
+ * Return Value: 1 if a live process was started from the file or has it mmapped, 0 otherwise
+ * Function: Its pages may be mapped straight from the file system image, so the file must not change.
+ */
+int32_t inode_mapped(uint32_t inode) {
+    pcb_t *pcb;
+    int i, j;
+
+    for (i = 0; i < NUM_PROCESSES; i++) {
+        pcb = get_pcb(i);
+        if (!cur_processes[i] || pcb->state == PROCESS_ZOMBIE) {
+            continue;
+        }
+        if (pcb->exe_inode == inode) {
+            return 1;
+        }
+        for (j = 0; j < MAX_MMAPS; j++) {
+            if (pcb->mmaps[j].pages != 0 && pcb->mmaps[j].inode == inode) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
 /* system_getargs(uint8_t* buf, int32_t nbytes)
  * Inputs: uint8_t* buf: buffer holding command line arguments, 
  * int32_t nbytes: bytes to be read.
@@ -473,12 +784,12 @@ int32_t system_close (int32_t fd) {
  */
 int32_t system_getargs(uint8_t* buf, int32_t nbytes) {
     // cli();
-    pcb_t *pcb = get_pcb(terminal_array[curr_terminal].pid);
+    pcb_t *pcb = get_pcb(curr_pid);
     if(strlen(pcb->args) + 1 > nbytes || strlen(pcb->args) == 0) { //+1 to account for '\0' b/c strlen doesn't count it
         return -1;
     }
     else { //if checks pass copy current aargs into user buffer
-        memcpy(buf, pcb->args, nbytes); 
+        memcpy(buf, pcb->args, strlen(pcb->args) + 1); 
         return 0;
     } 
     // sti();
@@ -490,7 +801,9 @@ int32_t system_getargs(uint8_t* buf, int32_t nbytes) {
  * Function: Sets up Video Map paging and gives user space access
  */
 int32_t system_vidmap(uint8_t** screen_start) {
-    
+    pcb_t *pcb = get_pcb(curr_pid);
+    uint32_t flags;
+
     if(screen_start == (uint8_t**) NULL || !(screen_start >= (uint8_t**) ONE_TWENTY_EIGHT_MB && screen_start <= (uint8_t**) ONE_THIRTY_TWO_MB)) {
         return -1;
     }
@@ -502,14 +815,168 @@ int32_t system_vidmap(uint8_t** screen_start) {
         page_directory[USER_ADDR_INDEX + 1].kb.global = 1;
         vid_map[0].present = 1; // set to present
         vid_map[0].user_supervisor = 1; //giving user access
-        vid_map[0].base_addr = (int) (VIDEO_ADDR / ALIGN); // set to vid mem
+        vid_map[0].base_addr = (int) (VIDEO_ADDR / ALIGN) + curr_terminal; // set to the terminal's page of vid mem
         flushTLB();
         *screen_start = (uint8_t*) ONE_TWENTY_EIGHT_MB + FOUR_MB; // setting start of virtual video memory
+
+        // the process draws on the page itself, the console stops flushing over it until the process halts
+        cli_and_save(flags);
+        if (!pcb->vidmapped) {
+            pcb->vidmapped = 1;
+            console_vidmap(pcb->terminal_id);
+        }
+        restore_flags(flags);
     }
 
     return 0;
 }
 
+/* unmap_user_pages(uint32_t pid, uint32_t start, uint32_t pages)
+ * Inputs: uint32_t pid: process whose user page table is in use,
+ * uint32_t start: page-aligned user virtual address,
+ * uint32_t pages: number of pages
+ * Return Value: none
+ * Function: Empties the page table entries of the range, giving back the frames the process owns.
+ * Call with interrupts off.
+ */
+static void unmap_user_pages(uint32_t pid, uint32_t start, uint32_t pages) {
+    page_table_entry_t* entry;
+    uint32_t i;
+
+    for (i = 0; i < pages; i++) {
+        entry = &user_page_tables[pid][PTE_INDEX(start + i * USER_PAGE_SIZE)];
+        if (entry->present && !(entry->avail & PTE_SHARED)) {
+            free_frame(entry->base_addr << shift_12);
+        }
+        memset(entry, 0, sizeof(page_table_entry_t));
+    }
+    flushTLB();
+}
+
+/* mmap_free_range(pcb_t* pcb, uint32_t pages)
+ * Inputs: pcb_t* pcb: current process,
+ * uint32_t pages: size of the range
+ * Return Value: start of the lowest free run of pages between MMAP_BASE and the stack, 0 if there is none
+ * Function: A page is free if nothing is mapped there and no ELF segment will be demand paged into it.
+ */
+static uint32_t mmap_free_range(pcb_t* pcb, uint32_t pages) {
+    uint32_t page;
+    uint32_t start = MMAP_BASE;
+    int i;
+
+    for (page = MMAP_BASE; page < USER_STACK_BOTTOM; page += USER_PAGE_SIZE) {
+        for (i = 0; i < pcb->num_segments; i++) {
+            if (pcb->segments[i].vaddr < page + USER_PAGE_SIZE && pcb->segments[i].vaddr + pcb->segments[i].memsz > page) {
+                break;
+            }
+        }
+        if (i < pcb->num_segments || user_page_tables[curr_pid][PTE_INDEX(page)].present) {
+            start = page + USER_PAGE_SIZE;
+        } else if (page + USER_PAGE_SIZE - start == pages * USER_PAGE_SIZE) {
+            return start;
+        }
+    }
+    return 0;
+}
+
+/* system_mmap(int32_t fd, int32_t offset, int32_t length)
+ * Inputs: int32_t fd: file descriptor index of an open regular file,
+ * int32_t offset: where the mapping starts in the file, a multiple of the page size,
+ * int32_t length: bytes to map, rounded up to whole pages; the range can't run past the last data block.
+ * Return Value: user virtual address of the mapping, -1 ("failure")
+ * Function: Maps the file's data blocks read-only into the process, straight from the file system
+ * image like shared program pages. Blocks the image doesn't hold page aligned are copied into frames
+ * the process owns instead. The file can't be written or unlinked until it is unmapped.
+ */
+int32_t system_mmap(int32_t fd, int32_t offset, int32_t length) {
+    pcb_t *pcb = get_pcb(curr_pid);
+    mmap_region_t *region = NULL;
+    uint32_t inode;
+    uint32_t pages;
+    uint32_t start;
+    uint32_t page;
+    uint32_t frame;
+    uint32_t i;
+
+    if (fd < 0 || fd >= FILE_DESCRIPTOR_MAX || pcb->file_descriptors[fd].flags == NOT_IN_USE ||
+        pcb->file_descriptors[fd].file_op_table_ptr != &file_ops) {
+        return -1;
+    }
+    if (offset < 0 || offset % USER_PAGE_SIZE != 0 || length <= 0 || length > USER_STACK_BOTTOM - MMAP_BASE) {
+        return -1;
+    }
+    for (i = 0; i < MAX_MMAPS; i++) {
+        if (pcb->mmaps[i].pages == 0) {
+            region = &pcb->mmaps[i];
+            break;
+        }
+    }
+    inode = pcb->file_descriptors[fd].inode;
+    pages = (length + USER_PAGE_SIZE - 1) / USER_PAGE_SIZE;
+    if (region == NULL || file_block_addr(inode, offset + (pages - 1) * USER_PAGE_SIZE) == NULL) {
+        return -1;
+    }
+    cli(); // the frame allocator and the inode_mapped check in unlink
+    start = mmap_free_range(pcb, pages);
+    if (start == 0) {
+        sti();
+        return -1;
+    }
+
+    for (i = 0; i < pages; i++) {
+        page = start + i * USER_PAGE_SIZE;
+        frame = image_page(inode, offset + i * USER_PAGE_SIZE);
+        if (frame != 0) {
+            map_user_page(curr_pid, page, frame, PTE_SHARED);
+            continue;
+        }
+        // a private copy, read-only like the pages mapped from the image, a write to either kills the process
+        frame = alloc_frame();
+        if (frame == NO_FRAME) {
+            unmap_user_pages(curr_pid, start, i);
+            sti();
+            return -1;
+        }
+        map_user_page(curr_pid, page, frame, 0);
+        memset((void*) page, 0, USER_PAGE_SIZE);
+        read_data(inode, offset + i * USER_PAGE_SIZE, (uint8_t*) page, USER_PAGE_SIZE);
+        user_page_tables[curr_pid][PTE_INDEX(page)].read_write = 0;
+    }
+    flushTLB();
+
+    region->start = start;
+    region->pages = pages;
+    region->inode = inode;
+    sti();
+    return start;
+}
+
+/* system_munmap(void* addr, int32_t length)
+ * Inputs: void* addr: address mmap returned,
+ * int32_t length: the length it was given
+ * Return Value: 0 (success), -1 ("failure")
+ * Function: Removes a whole mapping made by mmap.
+ */
+int32_t system_munmap(void* addr, int32_t length) {
+    pcb_t *pcb = get_pcb(curr_pid);
+    int i;
+
+    if (length <= 0) {
+        return -1;
+    }
+    for (i = 0; i < MAX_MMAPS; i++) {
+        if (pcb->mmaps[i].pages != 0 && pcb->mmaps[i].start == (uint32_t) addr &&
+            pcb->mmaps[i].pages == ((uint32_t) length + USER_PAGE_SIZE - 1) / USER_PAGE_SIZE) {
+            cli();
+            unmap_user_pages(curr_pid, pcb->mmaps[i].start, pcb->mmaps[i].pages);
+            pcb->mmaps[i].pages = 0;
+            sti();
+            return 0;
+        }
+    }
+    return -1;
+}
+
 /* system_set_handler(int32_t signum, void* handler_access)
  * Inputs: int32_t signum, void* handler_access
  * Return Value: 
@@ -528,24 +995,352 @@ int32_t system_sigreturn(void) {
     return -1;
 }
 
+/* system_set_priority(int32_t priority)
+ * Inputs: int32_t priority: SCHED_TOP_LEVEL (most favored) through SCHED_BOTTOM_LEVEL
+ * Return Value: 0 (success), -1 (failure)
+ * Function: Sets the level the calling process starts at and returns to when the scheduler boosts
+ * everyone or the process gets terminal input, like nice. Programs it executes inherit it.
+ */
+int32_t system_set_priority(int32_t priority) {
+    pcb_t *pcb = get_pcb(curr_pid);
+
+    if (priority < SCHED_TOP_LEVEL || priority > SCHED_BOTTOM_LEVEL) {
+        return -1;
+    }
+    cli();
+    pcb->base_priority = priority;
+    sched_set_level(curr_pid, priority);
+    sti();
+    return 0;
+}
+
+/* system_fork(void)
+ * Inputs: none
+ * Return Value: child's pid in the parent, 0 in the child, -1 (failure)
+ * Function: Creates a copy of the calling process. The child gets a copy of the pcb and the file
+ * descriptor array, and shares every user page with the parent copy-on-write. It starts out runnable
+ * and returns from the same system call through fork_child_return.
+ */
+int32_t system_fork(void) {
+    pcb_t *parent_pcb = get_pcb(curr_pid);
+    pcb_t *pcb;
+    page_table_entry_t *parent_table = user_page_tables[curr_pid];
+    syscall_frame_t *frame;
+    int32_t pid;
+    int i;
+
+    cli();
+    if ((pid = alloc_pid()) == -1) {
+        sti();
+        return -1;
+    }
+
+    // Same pcb and open files, then the fields that make it a different process
+    pcb = get_pcb(pid);
+    memcpy(pcb, parent_pcb, sizeof(pcb_t));
+    pcb->pid = pid;
+    pcb->parent_pid = curr_pid;
+    pcb->exit_status = 0;
+    init_wait_queue(&pcb->child_exit_queue);
+    pcb->wait_next = NO_PID;
+    pcb->run_next = NO_PID;
+    sched_set_level(pid, pcb->base_priority);
+    if (pcb->vidmapped) {
+        console_vidmap(pcb->terminal_id); // the child draws on the same page
+    }
+    for (i = 0; i < FILE_DESCRIPTOR_MAX; i++) {
+        pipe_ref(&pcb->file_descriptors[i]);
+    }
+
+    // Every page the parent owns becomes read-only in both processes until one of them writes it
+    for (i = 0; i < PAGE_SIZE; i++) {
+        if (!parent_table[i].present) {
+            continue;
+        }
+        if (!(parent_table[i].avail & PTE_SHARED)) {
+            if (parent_table[i].read_write) {
+                parent_table[i].read_write = 0;
+                parent_table[i].avail |= PTE_COW;
+            }
+            ref_frame(parent_table[i].base_addr << shift_12);
+        }
+    }
+    memcpy(user_page_tables[pid], parent_table, sizeof(user_page_tables[pid]));
+    flushTLB();
+
+    // The child's kernel stack holds a copy of our system call frame, with the linkage's saved kernel esp
+    // moved over to the child's stack. The scheduler's epilogue (leave; ret) lands in fork_child_return.
+    frame = (syscall_frame_t *) (EIGHT_MB - pid * EIGHT_KB - sizeof(syscall_frame_t));
+    memcpy(frame, (void *) (EIGHT_MB - curr_pid * EIGHT_KB - sizeof(syscall_frame_t)), sizeof(syscall_frame_t));
+    frame->esp += (curr_pid - pid) * EIGHT_KB;
+    frame->return_addr = (uint32_t) fork_child_return;
+    pcb->ebp = (uint32_t) frame - sizeof(uint32_t);  // [ebp] is the ebp that leave pops, [ebp+4] the return address
+    *(uint32_t *) pcb->ebp = frame->ebp;
+    pcb->esp = pcb->ebp - START_STACK_SLACK;
+
+    make_runnable(pid);
+    sti();
+    return pid;
+}
+
+/* alloc_pid()
+ * Inputs: none
+ * Return Value: a pid that is now marked in use, -1 if every pid is taken
+ * Function: Finds the first free slot in cur_processes.
+ */
+int32_t alloc_pid() {
+    int32_t i;
+
+    for (i = 0; i < NUM_PROCESSES; i++) {
+        if (cur_processes[i] == 0) { // not in use process
+            cur_processes[i] = 1;  // set to in use
+            return i;
+        }
+    }
+    return -1;
+}
+
 /* process_page(int process_id)
  * Inputs: int process_id: process_id that we want to set up paging for
  * Return Value: nothing
  * Function: Makes sure process id is valid,
- * Sets page directory, at user address index, values to correct values.
+ * Points the page directory entry at user address index to the process's user page table.
  */
 void process_page(int process_id) {
     // parameter checks
     if (process_id >= 0 && process_id < NUM_PROCESSES) {
         // set page directory entry
-        // index will never change (virtual mem), base_addr will change (phys mem)
-        page_directory[USER_ADDR_INDEX].mb.present = 1;
-        page_directory[USER_ADDR_INDEX].mb.base_addr = (EIGHT_MB + FOUR_MB*process_id) >> shift_22;
-        page_directory[USER_ADDR_INDEX].mb.user_supervisor = 1;
-        page_directory[USER_ADDR_INDEX].mb.global = 1;
+        // index will never change (virtual mem), the page table holds this process's frames
+        page_directory[USER_ADDR_INDEX].kb.present = 1;
+        page_directory[USER_ADDR_INDEX].kb.read_write = 1;
+        page_directory[USER_ADDR_INDEX].kb.user_supervisor = 1;
+        page_directory[USER_ADDR_INDEX].kb.reserved = 0;
+        page_directory[USER_ADDR_INDEX].kb.page_size = 0;   // 4 kB pages
+        page_directory[USER_ADDR_INDEX].kb.global = 0;
+        page_directory[USER_ADDR_INDEX].kb.base_addr = ((unsigned int)(user_page_tables[process_id]) >> shift_12);
     }
 }
 
+/* map_zeroed_pages(uint32_t pid, uint32_t start, uint32_t end)
+ * Inputs: uint32_t pid: process whose user page table is in use,
+ * uint32_t start, end: user virtual address range
+ * Return Value: 0 (success), -1 (out of memory)
+ * Function: Gives every page of the range that isn't mapped yet a fresh zeroed frame.
+ * The process's page table must be the one in use.
+ */
+int32_t map_zeroed_pages(uint32_t pid, uint32_t start, uint32_t end) {
+    uint32_t page;
+    uint32_t frame;
+
+    for (page = start & ~(USER_PAGE_SIZE - 1); page < end; page += USER_PAGE_SIZE) {
+        if (user_page_tables[pid][PTE_INDEX(page)].present) {
+            continue; // shared with the segment before it
+        }
+        frame = alloc_frame();
+        if (frame == NO_FRAME) {
+            return -1;
+        }
+        map_user_page(pid, page, frame, 0);
+        memset((void*) page, 0, USER_PAGE_SIZE);
+    }
+    return 0;
+}
+
+/* load_program(uint32_t inode, uint32_t pid)
+ * Inputs: uint32_t inode: inode of the executable,
+ * uint32_t pid: process to load it into
+ * Return Value: 0 (success), -1 (bad ELF)
+ * Function: Checks the ELF's loadable segments and remembers them in the pcb. Nothing is copied yet:
+ * every user page starts out not present and demand_page fills it in on the first touch.
+ */
+int32_t load_program(uint32_t inode, uint32_t pid) {
+    pcb_t* pcb = get_pcb(pid);
+    elf_phdr_t phdrs[ELF_MAX_PHDRS];
+    uint32_t phoff = 0;
+    uint16_t phentsize = 0;
+    uint16_t phnum = 0;
+    int i;
+
+    read_data(inode, ELF_PHOFF, (uint8_t*) &phoff, sizeof(phoff));
+    read_data(inode, ELF_PHENTSIZE, (uint8_t*) &phentsize, sizeof(phentsize));
+    read_data(inode, ELF_PHNUM, (uint8_t*) &phnum, sizeof(phnum));
+    if (phentsize != sizeof(elf_phdr_t) || phnum > ELF_MAX_PHDRS ||
+            read_data(inode, phoff, (uint8_t*) phdrs, phnum * sizeof(elf_phdr_t)) != phnum * sizeof(elf_phdr_t)) {
+        return -1;
+    }
+
+    pcb->exe_inode = inode;
+    pcb->num_segments = 0;
+    for (i = 0; i < phnum; i++) {
+        if (phdrs[i].type != ELF_PT_LOAD) {
+            continue;
+        }
+        // the segment has to fit in the user region below the stack
+        if (phdrs[i].vaddr < ONE_TWENTY_EIGHT_MB || phdrs[i].filesz > phdrs[i].memsz ||
+                phdrs[i].memsz > USER_STACK_BOTTOM - phdrs[i].vaddr) {
+            return -1;
+        }
+        pcb->segments[pcb->num_segments++] = phdrs[i];
+    }
+    return 0;
+}
+
+/* image_page(uint32_t inode, uint32_t offset)
+ * Inputs: uint32_t inode: inode of a regular file,
+ * uint32_t offset: page-aligned byte offset in the file
+ * Return Value: physical address of the data block holding that part of the file, 0 if it can't be mapped
+ * Function: A data block can be mapped into user space as a page if the image holds it page aligned
+ * and inside the kernel's identity mapped 4 MB.
+ */
+uint32_t image_page(uint32_t inode, uint32_t offset) {
+    uint8_t* block = file_block_addr(inode, offset);
+
+    if (block == NULL || ((uint32_t) block & (USER_PAGE_SIZE - 1)) || (uint32_t) block >= EIGHT_MB) {
+        return 0;
+    }
+    return (uint32_t) block;
+}
+
+/* shared_program_page(pcb_t* pcb, uint32_t page, uint32_t* avail)
+ * Inputs: pcb_t* pcb: process that faulted,
+ * uint32_t page: page-aligned user virtual address,
+ * uint32_t* avail: loaded with the page table avail bits to map the page with
+ * Return Value: physical address of the file system data block holding the page, 0 if the page has to be copied
+ * Function: A page can be mapped straight from the image if it belongs to a single segment, lines up with a
+ * whole data block, and holds no bss. Read-only segments may also share their last partial page, the rest of
+ * the block is just more of the file.
+ */
+uint32_t shared_program_page(pcb_t* pcb, uint32_t page, uint32_t* avail) {
+    elf_phdr_t* segment = NULL;
+    uint32_t block;
+    int i;
+
+    for (i = 0; i < pcb->num_segments; i++) {
+        if (pcb->segments[i].vaddr < page + USER_PAGE_SIZE && pcb->segments[i].vaddr + pcb->segments[i].memsz > page) {
+            if (segment != NULL) {
+                return 0; // two segments in one page
+            }
+            segment = &pcb->segments[i];
+        }
+    }
+    if (segment == NULL || page < segment->vaddr || (segment->offset + page - segment->vaddr) % BYTES_PER_BLOCK != 0) {
+        return 0;
+    }
+    if (page + USER_PAGE_SIZE > segment->vaddr + segment->filesz &&
+            ((segment->flags & ELF_PF_W) || segment->filesz != segment->memsz)) {
+        return 0;
+    }
+
+    block = image_page(pcb->exe_inode, segment->offset + page - segment->vaddr);
+    if (block == 0) {
+        return 0;
+    }
+    *avail = (segment->flags & ELF_PF_W) ? (PTE_SHARED | PTE_COW) : PTE_SHARED;
+    return block;
+}
+
+/* demand_page(uint32_t addr)
+ * Inputs: uint32_t addr: user virtual address that faulted
+ * Return Value: 0 (page is mapped now), -1 (addr isn't part of the process, or out of memory)
+ * Function: Page fault handler for not-present user pages of the current process. Pages of an ELF
+ * segment get the file bytes that fall in them copied from the file system image, the rest of the
+ * page (bss) is zero. Pages in the stack area are just zeroed. With share_program_pages, whole pages of the
+ * file are mapped from the image instead: read-only, or copy-on-write for writable segments.
+ */
+int32_t demand_page(uint32_t addr) {
+    pcb_t* pcb = get_pcb(curr_pid);
+    uint32_t page = addr & ~(USER_PAGE_SIZE - 1);
+    uint32_t page_end = page + USER_PAGE_SIZE;
+    uint32_t start;
+    uint32_t end;
+    uint32_t frame;
+    uint32_t avail;
+    int32_t in_segment = 0;
+    int i;
+
+    if (curr_pid == NO_PID || addr < ONE_TWENTY_EIGHT_MB || addr >= USER_REGION_END) {
+        return -1;
+    }
+    for (i = 0; i < pcb->num_segments; i++) {
+        if (pcb->segments[i].vaddr < page_end && pcb->segments[i].vaddr + pcb->segments[i].memsz > page) {
+            in_segment = 1;
+        }
+    }
+    if (!in_segment && page < USER_STACK_BOTTOM) {
+        return -1;
+    }
+
+    if (in_segment && share_program_pages && (frame = shared_program_page(pcb, page, &avail)) != 0) {
+        map_user_page(curr_pid, page, frame, avail);
+        return 0;
+    }
+
+    if (map_zeroed_pages(curr_pid, page, page_end) == -1) {
+        return -1;
+    }
+
+    // copy the part of each segment's file bytes that lands in this page
+    for (i = 0; i < pcb->num_segments; i++) {
+        start = pcb->segments[i].vaddr;
+        end = start + pcb->segments[i].filesz;
+        if (start < page) {
+            start = page;
+        }
+        if (end > page_end) {
+            end = page_end;
+        }
+        if (start < end) {
+            read_data(pcb->exe_inode, pcb->segments[i].offset + (start - pcb->segments[i].vaddr),
+                      (uint8_t*) start, end - start);
+        }
+    }
+    return 0;
+}
+
+/* copy_on_write(uint32_t addr)
+ * Inputs: uint32_t addr: user virtual address of a write that hit a read-only page
+ * Return Value: 0 (the page is private and writable now), -1 (the page isn't copy-on-write, or out of memory)
+ * Function: Page fault handler for writes to copy-on-write pages of the current process. Copies the
+ * shared page into a new frame the process owns, or just makes it writable again if no other process
+ * maps the frame any more.
+ */
+int32_t copy_on_write(uint32_t addr) {
+    uint32_t page = addr & ~(USER_PAGE_SIZE - 1);
+    page_table_entry_t* entry;
+    uint32_t frame;
+    uint32_t old_frame;
+    uint32_t shared;
+
+    if (curr_pid == NO_PID || addr < ONE_TWENTY_EIGHT_MB || addr >= USER_REGION_END) {
+        return -1;
+    }
+    entry = &user_page_tables[curr_pid][PTE_INDEX(page)];
+    if (!entry->present || !(entry->avail & PTE_COW)) {
+        return -1;
+    }
+    old_frame = entry->base_addr << shift_12;
+    shared = entry->avail & PTE_SHARED;
+
+    if (!shared && frame_refs(old_frame) == 1) {
+        map_user_page(curr_pid, page, old_frame, 0);
+        flushTLB();
+        return 0;
+    }
+
+    frame = alloc_frame();
+    if (frame == NO_FRAME) {
+        return -1;
+    }
+    // the old page is still readable at its user address
+    memcpy(map_scratch_page(frame), (void*) page, USER_PAGE_SIZE);
+    map_user_page(curr_pid, page, frame, 0);
+    flushTLB();
+    if (!shared) {
+        free_frame(old_frame); // one less process mapping the old copy
+    }
+    return 0;
+}
+
 /* get_pcb(uint32_t pid)
  * Inputs: uint32_t pid: process_id that we want to get correct pcb pointer for
  * Return Value: pcb pointer
@@ -554,17 +1349,3 @@ void process_page(int process_id) {
 pcb_t* get_pcb(uint32_t pid) {
     return (pcb_t *) (EIGHT_MB - (pid + 1) * EIGHT_KB); // pcb start address formula
 }
-
-/* update_tss(int new_pid, int terminal_id)
- * DESCRIPTION: Updates tss values of the inputted terminal
- * Inputs: int new_pid: pid used for tss_esp0 calculation, 
- *         int terminal_id: terminal index for terminal array (which terminal to alter)
- * Outputs: none
- * Return Value: none
- * Function: Used in halt and execute to alter the base tss values of each terminal
- */
-void update_tss(int new_pid, int terminal_id){
-    terminal_array[terminal_id].base_tss_esp0 = EIGHT_MB - new_pid * EIGHT_KB;
-    terminal_array[terminal_id].base_tss_ss0 = KERNEL_DS;
-}
-
@@ -3,6 +3,7 @@
 
 #include "types.h"
 #include "x86_desc.h"
+#include "sched.h"
 
 #define FILE_DESCRIPTOR_MAX 8
 #define FILE_DESCRIPTOR_MIN 2
@@ -18,7 +19,7 @@
 #define EIGHT_MB    0x800000
 #define FOUR_MB     0x400000
 #define EIGHT_KB    0x2000
-#define NUM_PROCESSES   6
+#define NUM_PROCESSES   32
 #define VIRTUAL_ADDR    0x08048000
 #define USER_ADDR_INDEX 32
 #define USER_ESP        0x083FFFFC
@@ -28,14 +29,74 @@
 #define EXCEPTION       255
 #define ONE_TWENTY_EIGHT_MB (FOUR_MB*32)
 #define ONE_THIRTY_TWO_MB (ONE_TWENTY_EIGHT_MB+FOUR_MB) 
-#define BASE_SHELL 24
+#define BASE_SHELL NUM_PROCESSES // parent_pid of a base shell, never a real pid
+#define NO_PARENT (NUM_PROCESSES + 1) // parent_pid of an orphan, it frees its own pid when it halts
+#define WAIT_ANY    -1  // waitpid for whichever child halts first
+#define WNOHANG     1   // waitpid option: don't block if no child has halted yet
 
 #define NUM_COLS    80
 
-/* The pid corresponding to the terminal that we are currently looking at. */
-uint32_t curr_pid;
+// ELF header fields used by the program loader
+#define ELF_ENTRY       24  // offset of the entry point
+#define ELF_PHOFF       28  // offset of the program header table's file offset
+#define ELF_PHENTSIZE   42  // offset of the size of one program header
+#define ELF_PHNUM       44  // offset of the number of program headers
+#define ELF_MAX_PHDRS   8
+#define ELF_PT_LOAD     1
+#define ELF_PF_W        0x2 // segment is writable
+#define USER_PAGE_SIZE      0x1000
+#define USER_REGION_END     (ONE_TWENTY_EIGHT_MB + FOUR_MB)
+#define USER_STACK_PAGES    64  // the stack can grow this many pages down from USER_ESP
+#define START_STACK_SLACK   64  // room below the first kernel frame of a new or forked process
+#define USER_EFLAGS         0x202   // interrupts on for a new process
+#define MAX_ARGS_LEN        128     // as long as a line of terminal input
+#define USER_STACK_BOTTOM   (USER_REGION_END - USER_STACK_PAGES * USER_PAGE_SIZE)
+#define MMAP_BASE           (ONE_TWENTY_EIGHT_MB + 0x100000)  // mmap places files between here and the stack
+#define MAX_MMAPS           8   // mapped files per process
+
+/* A file range mmap mapped into the process */
+typedef struct mmap_region {
+    uint32_t start;     // user virtual address of the first page
+    uint32_t pages;     // 0 marks a free slot
+    uint32_t inode;     // the file's pages can't change while it is mapped
+} mmap_region_t;
+
+/* What a system call from user space leaves at the top of its kernel stack, lowest address first */
+typedef struct syscall_frame {
+    uint32_t return_addr;   // into system_call_linkage
+    uint32_t args[4];       // ebx, ecx, edx, esi again as the C arguments
+    uint32_t ebx;           // registers saved by system_call_linkage
+    uint32_t ecx;
+    uint32_t edx;
+    uint32_t esi;
+    uint32_t edi;
+    uint32_t ebp;
+    uint32_t esp;           // kernel esp, restored with popl %esp
+    uint32_t eflags;
+    uint32_t eip;           // pushed by the CPU on the way in
+    uint32_t cs;
+    uint32_t user_eflags;
+    uint32_t user_esp;
+    uint32_t ss;
+} syscall_frame_t;
+
+/* ELF program header, one per segment */
+typedef struct elf_program_header {
+    uint32_t type;
+    uint32_t offset;
+    uint32_t vaddr;
+    uint32_t paddr;
+    uint32_t filesz;
+    uint32_t memsz;
+    uint32_t flags;
+    uint32_t align;
+} elf_phdr_t;
 
 int32_t system_execute(const uint8_t* command);
+int32_t system_spawn(const uint8_t* command);
+int32_t system_waitpid(int32_t pid, int32_t* status, int32_t options);
+int32_t system_wait(int32_t* status);
+int32_t wait_child(int32_t pid, int32_t* status, int32_t options);
 int32_t system_halt(uint8_t status);
 int32_t system_read (int32_t fd, void* buf, int32_t nbytes);
 int32_t system_write (int32_t fd, const void* buf, int32_t nbytes);
@@ -45,8 +106,27 @@ int32_t system_getargs(uint8_t* buf, int32_t nbytes);
 int32_t system_vidmap(uint8_t** screen_start);
 int32_t system_set_handler(int32_t signum, void* handler_access);
 int32_t system_sigreturn(void);
+int32_t system_set_priority(int32_t priority);
+int32_t system_fork(void);
+int32_t system_dup2(int32_t oldfd, int32_t newfd);
+int32_t close_fd(int32_t fd);
+int32_t system_create(const uint8_t* filename);
+int32_t system_unlink(const uint8_t* filename);
+int32_t system_getdents(int32_t fd, void* buf, int32_t nbytes);
+int32_t system_stat(const uint8_t* filename, void* buf);
+int32_t system_fstat(int32_t fd, void* buf);
+int32_t system_lseek(int32_t fd, int32_t offset, int32_t whence);
+int32_t system_pread(int32_t fd, void* buf, int32_t nbytes, int32_t offset);
+int32_t system_mmap(int32_t fd, int32_t offset, int32_t length);
+int32_t system_munmap(void* addr, int32_t length);
+int32_t inode_mapped(uint32_t inode);
 
 void process_page(int process_num);
+int32_t alloc_pid();
+int32_t load_program(uint32_t inode, uint32_t pid);
+int32_t map_zeroed_pages(uint32_t pid, uint32_t start, uint32_t end);
+int32_t demand_page(uint32_t addr);
+int32_t copy_on_write(uint32_t addr);
 void init_fops_table();
 
 typedef struct file_op_table {
@@ -58,9 +138,13 @@ typedef struct file_op_table {
 
 typedef struct file_descriptor {
     fops_t *file_op_table_ptr; /* The file operations jump table associated with the correct file type. */
-    int32_t inode; /* The inode number for this file. This is only valid for data files, and should be 0 for directories and the RTC device file. */
+    int32_t inode; /* The inode number for this file. This is only valid for data files, and should be 0 for directories and the RTC device file. Pipe ends keep their pipe's index here. */
     int32_t file_pos; /* Keeps track of where the user is currently reading from in the file. Every read system call should update this member. */
     int32_t flags; /* Among other things, marking this file descriptor as “in-use.” */
+    uint8_t* cursor_block; /* Data files: data block holding byte cursor_pos, NULL until the first read. */
+    uint32_t cursor_offset; /* Offset of cursor_pos in cursor_block. */
+    uint32_t cursor_pos; /* File position the cursor is at, a read from anywhere else looks the block up again. */
+    uint32_t cursor_run; /* Bytes from the cursor to the end of the read-ahead window of consecutive data blocks. */
 } fd_t;
 
 int32_t system_read (int32_t fd, void* buf, int32_t nbytes);
@@ -78,10 +162,33 @@ typedef struct process_control_block {
     uint32_t eip;
     uint32_t tss_esp0;
     uint32_t tss_ss0;
-    char* args; // keeps track of current arguments inputted per process
+    char args[MAX_ARGS_LEN]; // keeps track of current arguments inputted per process
+    int32_t state; // PROCESS_RUNNING, PROCESS_RUNNABLE, PROCESS_BLOCKED or PROCESS_ZOMBIE
+    int32_t run_next; // next pid on the run queue
+    int32_t wait_next; // next pid on the wait queue this process is blocked on
+    int32_t rtc_max_counter; // RTC interrupts per virtual RTC tick of this process
+    int32_t rtc_counter; // RTC interrupts left before a blocked RTC_read returns
+    int32_t priority; // run queue level, SCHED_TOP_LEVEL runs first
+    int32_t base_priority; // level the process returns to on boosts and terminal input, set by set_priority
+    int32_t slice_left; // PIT input clocks left in the current time slice
+    uint32_t exe_inode; // inode of the executable, user pages are loaded from it when first touched
+    int32_t num_segments; // loadable ELF segments in segments[]
+    elf_phdr_t segments[ELF_MAX_PHDRS];
+    mmap_region_t mmaps[MAX_MMAPS]; // files mapped with mmap
+    int32_t vidmapped; // set once vidmap gave the process its terminal's text memory
+    int32_t exit_status; // halt status kept for waitpid while the process is a zombie
+    wait_queue_t child_exit_queue; // this process sleeps here in waitpid until a child halts
 } pcb_t;
 
 pcb_t* get_pcb(uint32_t pid);
+uint32_t image_page(uint32_t inode, uint32_t offset);
+uint32_t shared_program_page(pcb_t* pcb, uint32_t page, uint32_t* avail);
+
+/* Exec maps program pages from the file system image when it can, 0 copies every page */
+extern int share_program_pages;
+
+/* 1 for each pid in use */
+extern int cur_processes[NUM_PROCESSES];
 
 fops_t term_write_ops;
 fops_t term_read_ops;
@@ -89,10 +196,10 @@ fops_t term_read_ops;
 fops_t rtc_ops;
 fops_t file_ops;
 fops_t dir_ops;
+fops_t pipe_read_ops;
+fops_t pipe_write_ops;
 
 /* Flag that allows us to check if the PCB we are creating is for a base shell. We initially set this to 1 because the first program we always run is the base shell. */
 int base_shell;
 
-void update_tss(int new_pid, int terminal_id);
-
 #endif
@@ -4,6 +4,8 @@
 #ifndef ASM
 
 extern void system_call_linkage();
+extern void fork_child_return();
+extern void process_start();
 
 #endif
 
@@ -20,9 +20,9 @@ void init_terminal() {
         terminal_array[i].screen_x = 0;
         terminal_array[i].screen_y = 0;
         terminal_array[i].flag = 0;
-        terminal_array[i].pid = -1;
         terminal_array[i].waitingInRead  = 0;
         terminal_array[i].enter_flag = 0;
+        init_interactive_wait_queue(&terminal_array[i].read_queue);
     }
     // At the start, only the first terminal (terminal 0) will be active
     terminal_array[0].flag = 1; 
@@ -32,11 +32,15 @@ void init_terminal() {
     terminal_array[1].attribute= 0x70; // reverse reverse
     terminal_array[2].attribute = 0x9F; // white text, blue bg
 
+    /* Each terminal draws into its own page of text memory, terminal 0's is shown first. */
+    display_terminal(0);
+
 }
 
 /* 
  * terminal_read
  *   DESCRIPTION: When enter is pressed, copies the terminal buffer into the userspace buffer.
+ *                Until then the process sleeps on the terminal's read queue, so it takes no CPU time.
  *   INPUTS: fd -- The file descriptor.
  *           user_buf -- The buffer to copy to.
  *           count -- How many bytes to read.
@@ -63,12 +67,11 @@ int32_t terminal_read(int32_t fd, void* buf, int32_t nbytes) {
     /* Indicates that this is a program that uses user input. */
     terminal_array[curr_terminal].waitingInRead = 1;
 
-    while (1){
+    /* Park until edit_buffer sees ENTER and wakes us up. */
+    cli();
+    while (terminal_array[curr_terminal].enter_flag != 1){
+        sleep_on(&terminal_array[curr_terminal].read_queue);
         cli();
-        if (terminal_array[curr_terminal].enter_flag == 1){
-            break;
-        }
-        sti();
     }
 
     if(MAX_BUF_SIZE < nbytes){
@@ -113,7 +116,6 @@ int32_t terminal_read(int32_t fd, void* buf, int32_t nbytes) {
  */
 int32_t terminal_write(int32_t fd, const void* buf, int32_t nbytes) {
     int numbytes = 0; /* Number of bytes written. */
-    int i; /* Iterates through the user buffer. */
 
     /* Parameter checking.*/
     if (buf == NULL){
@@ -123,14 +125,9 @@ int32_t terminal_write(int32_t fd, const void* buf, int32_t nbytes) {
         return -1;
     }
 
-    /* Prints characters from the write buffer to the screen. */
+    /* Prints the write buffer to the screen in one go. */
     cli();
-    for (i = 0; i < nbytes; i++){
-        if (((uint8_t *)buf)[i] != NULL) {
-            putc(((uint8_t *)buf)[i]);
-            numbytes++;
-        }
-    }
+    numbytes = putbuf(curr_terminal, (const uint8_t *)buf, nbytes);
     sti();
     return numbytes;
 
@@ -142,19 +139,20 @@ int32_t terminal_write(int32_t fd, const void* buf, int32_t nbytes) {
  *   INPUTS: response -- Retrieved from the keyboard handler, the character to add to the terminal buffer.
  *   OUTPUTS: none
  *   RETURN VALUE: Returns 0 on success.
- *   SIDE EFFECTS: 
+ *   SIDE EFFECTS: Wakes the processes reading from the screen terminal when ENTER completes a line.
  */
 int edit_buffer(uint8_t response) {
     cli();
     int i; /* Loops through the terminal buffer. */
 
+    /* Typing goes back to the live screen if the user was reading the scrollback. */
+    view_live(screen_terminal);
+
     /* Clearing the screen with the CTRL-L command */
     if (response == CTL_L_CMD){
-        DISPLAY_ON_MAIN_PAGE = 1;
-        clear();
+        term_clear(screen_terminal);
         for (i = 0; i < terminal_array[screen_terminal].buffer_size; i++) {
-            DISPLAY_ON_MAIN_PAGE = 1;
-            putc(terminal_array[screen_terminal].buffer[i] );
+            term_putc(screen_terminal, terminal_array[screen_terminal].buffer[i]);
         }
     }
     /* Case when the user wants to edit the buffer and is currently in a program that takes user input. */
@@ -162,10 +160,10 @@ int edit_buffer(uint8_t response) {
         /* Case where the terminal buffer is almost full, just waiting for ENTER KEY. */ 
         if (terminal_array[screen_terminal].buffer_size == MAX_BUF_SIZE-2 && response == ENTER_KEY){
             terminal_array[screen_terminal].buffer[terminal_array[screen_terminal].buffer_size] = END_OF_LINE;
-            DISPLAY_ON_MAIN_PAGE = 1;
-            putc('\n');
+            term_putc(screen_terminal, '\n');
             terminal_array[screen_terminal].enter_flag = 1;
             terminal_array[screen_terminal].buffer_size++;
+            wake_up(&terminal_array[screen_terminal].read_queue);
 
         }
         /* Case to delete from the buffer. */
@@ -186,15 +184,14 @@ int edit_buffer(uint8_t response) {
             }
             else if (response == ENTER_KEY) {
                 terminal_array[screen_terminal].buffer[terminal_array[screen_terminal].buffer_size] = END_OF_LINE;
-                DISPLAY_ON_MAIN_PAGE = 1;
-                putc('\n');
+                term_putc(screen_terminal, '\n');
                 terminal_array[screen_terminal].enter_flag = 1;
                 terminal_array[screen_terminal].buffer_size++;
+                wake_up(&terminal_array[screen_terminal].read_queue);
             }
             else {
                 terminal_array[screen_terminal].buffer[terminal_array[screen_terminal].buffer_size] = response;
-                DISPLAY_ON_MAIN_PAGE = 1;
-                putc(response);
+                term_putc(screen_terminal, response);
                 terminal_array[screen_terminal].buffer_size++;
             }
         }
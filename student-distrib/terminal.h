@@ -2,6 +2,7 @@
 #define _TERMINAL_
 
 #include "lib.h"
+#include "sched.h"
 
 #define CTL_PRESSED    0x1D
 #define BACKSPACE_PRESSED 0x0E
@@ -11,9 +12,6 @@
 #define MAX_TERMINALS 3
 #define CTL_L_CMD 255
 
-//typing flag to let lib.c no to display on main video page
-int DISPLAY_ON_MAIN_PAGE;
-
 //Keeps track of Terminal being looked at (Displayed Terminal)
 int screen_terminal;
 
@@ -28,12 +26,10 @@ typedef struct terminal_info {
     int screen_y;
     uint8_t buffer[MAX_BUF_SIZE];
     uint8_t buffer_size;
-    int pid;
-    uint32_t base_tss_esp0;
-    uint32_t base_tss_ss0;
     int waitingInRead;
     int enter_flag;
     uint8_t attribute;
+    wait_queue_t read_queue; /* processes blocked in terminal_read until ENTER is pressed */
 } terminal_info_t;
 
 
@@ -5,6 +5,8 @@
 #include "rtc.h"
 #include "terminal.h"
 #include "syscalls.h"
+#include "pit.h"
+#include "frame.h"
 
 #define PASS 1
 #define FAIL 0
@@ -22,6 +24,7 @@ static inline void assertion_failure(){
 }
 
 int32_t RTC_read(int32_t fd, void* buffer, int32_t nbytes);
+extern boot_block_t* boot_block;
 int32_t RTC_write(int32_t fd, const void* buffer, int32_t nbytes);
 
 /* Checkpoint 1 tests */
@@ -258,6 +261,456 @@ int read_data_test(){
 
 
 
+/* read_data_timing_test
+ * Inputs: None
+ * Outputs: PASS on pass
+ * Side Effects: Prints the cost of read_data in cycles per byte
+ * Coverage: times a whole-file read_data of the large text file against reading it one byte per call
+ */
+int read_data_timing_test(){
+	TEST_HEADER;
+	uint8_t buf[BYTES_PER_BLOCK*2];
+	dentry_t dentry;
+	uint32_t start, whole_cycles, byte_cycles;
+	int32_t bytes_read;
+	int i, j;
+
+	if (read_dentry_by_name((const uint8_t *) "verylargetextwithverylongname.tx", &dentry) != 0) {
+		return FAIL;
+	}
+
+	/* whole file per call */
+	start = rdtsc();
+	for (i = 0; i < 16; i++) { // repeat to smooth out the measurement
+		bytes_read = read_data(dentry.inode_num, 0, buf, sizeof(buf));
+	}
+	whole_cycles = rdtsc() - start;
+	if (bytes_read <= 0) {
+		return FAIL;
+	}
+
+	/* one byte per call, how small user reads see it */
+	start = rdtsc();
+	for (i = 0; i < 16; i++) {
+		for (j = 0; j < bytes_read; j++) {
+			if (read_data(dentry.inode_num, j, buf + j, 1) != 1) {
+				return FAIL;
+			}
+		}
+	}
+	byte_cycles = rdtsc() - start;
+
+	printf("%d bytes, whole file: %d cycles/byte, per byte: %d cycles/byte\n", bytes_read,
+		whole_cycles / (16 * bytes_read), byte_cycles / (16 * bytes_read));
+
+	return PASS;
+}
+
+/* The fd tests run from kernel.c before any process exists, but read_file and friends find their fds
+ * through curr_pid. They borrow the last pid's PCB, far below the boot stack, while they run. */
+#define TEST_PID (NUM_PROCESSES - 1)
+static uint32_t test_flags;
+
+/* begin_fd_test
+ * Inputs: None
+ * Outputs: The fds of the borrowed PCB, all closed
+ * Side Effects: Interrupts off and curr_pid is TEST_PID until end_fd_test
+ */
+static fd_t* begin_fd_test(){
+	pcb_t* pcb = get_pcb(TEST_PID);
+	int i;
+
+	cli_and_save(test_flags);
+	curr_pid = TEST_PID;
+	for (i = 0; i < FILE_DESCRIPTOR_MAX; i++) {
+		pcb->file_descriptors[i].flags = NOT_IN_USE;
+	}
+	return pcb->file_descriptors;
+}
+
+/* end_fd_test
+ * Inputs: None
+ * Outputs: None
+ * Side Effects: Gives the PCB back, curr_pid is NO_PID again
+ */
+static void end_fd_test(){
+	curr_pid = NO_PID;
+	restore_flags(test_flags);
+}
+
+/* read_file_cursor_test
+ * Inputs: None
+ * Outputs: PASS on pass
+ * Side Effects: Uses fd 2 of a borrowed pcb, prints the cost of the first and last small read
+ * Coverage: reads the large text file 64 bytes at a time through read_file and checks it against read_data
+ */
+int read_file_cursor_test(){
+	TEST_HEADER;
+	uint8_t buf[64];
+	uint8_t check[64];
+	dentry_t dentry;
+	fd_t* file;
+	uint32_t start, cycles, first_cycles = 0, last_cycles = 0;
+	int32_t bytes_read, offset = 0;
+	int result = PASS;
+	int i;
+
+	if (read_dentry_by_name((const uint8_t *) "verylargetextwithverylongname.tx", &dentry) != 0) {
+		return FAIL;
+	}
+	file = &begin_fd_test()[2];
+	file->file_op_table_ptr = &file_ops;
+	file->inode = dentry.inode_num;
+	file->file_pos = 0;
+	file->cursor_block = NULL;
+	file->flags = IN_USE;
+
+	while (1) {
+		start = rdtsc();
+		bytes_read = read_file(2, buf, sizeof(buf));
+		cycles = rdtsc() - start;
+		if (bytes_read <= 0) {
+			break;
+		}
+		if (offset == 0) {
+			first_cycles = cycles;
+		}
+		last_cycles = cycles;
+		if (read_data(dentry.inode_num, offset, check, bytes_read) != bytes_read) {
+			result = FAIL;
+			break;
+		}
+		for (i = 0; i < bytes_read; i++) {
+			if (buf[i] != check[i]) {
+				result = FAIL;
+			}
+		}
+		offset += bytes_read;
+	}
+	file->flags = NOT_IN_USE;
+	end_fd_test();
+
+	printf("%d bytes, first read: %d cycles, last read: %d cycles\n", offset, first_cycles, last_cycles);
+	return (bytes_read == 0) ? result : FAIL;
+}
+
+/* lseek_pread_test
+ * Inputs: None
+ * Outputs: PASS on pass
+ * Side Effects: Uses fd 2 of a borrowed pcb
+ * Coverage: a short read leaves the position at the end of the file, lseek moves it, pread leaves it alone
+ */
+int lseek_pread_test(){
+	TEST_HEADER;
+	uint8_t buf[64];
+	uint8_t check[64];
+	dentry_t dentry;
+	fd_t* file;
+	uint32_t length;
+	int result = PASS;
+	int i;
+
+	if (read_dentry_by_name((const uint8_t *) "verylargetextwithverylongname.tx", &dentry) != 0) {
+		return FAIL;
+	}
+	file = &begin_fd_test()[2];
+	file->file_op_table_ptr = &file_ops;
+	file->inode = dentry.inode_num;
+	file->file_pos = 0;
+	file->cursor_block = NULL;
+	file->flags = IN_USE;
+	length = lseek_file(2, 0, SEEK_END);
+
+	/* the last 10 bytes, then nothing */
+	if (lseek_file(2, -10, SEEK_END) != length - 10 || read_file(2, buf, sizeof(buf)) != 10 ||
+		file->file_pos != length || read_file(2, buf, sizeof(buf)) != 0 || file->file_pos != length) {
+		result = FAIL;
+	}
+	if (lseek_file(2, -1, SEEK_SET) != -1 || lseek_file(2, 0, 3) != -1) {
+		result = FAIL;
+	}
+
+	/* back to the middle, read, then pread from the start without moving */
+	lseek_file(2, length / 2, SEEK_SET);
+	read_file(2, buf, sizeof(buf));
+	read_data(dentry.inode_num, length / 2, check, sizeof(check));
+	for (i = 0; i < sizeof(buf); i++) {
+		if (buf[i] != check[i]) {
+			result = FAIL;
+		}
+	}
+	if (pread_file(2, buf, sizeof(buf), 0) != sizeof(buf) || lseek_file(2, 0, SEEK_CUR) != length / 2 + sizeof(buf)) {
+		result = FAIL;
+	}
+
+	file->flags = NOT_IN_USE;
+	end_fd_test();
+	return result;
+}
+
+/* image_page_test
+ * Inputs: None
+ * Outputs: PASS on pass
+ * Side Effects: None
+ * Coverage: every page of a file mmap could map is its page aligned data block in the image, and nothing past the end
+ */
+int image_page_test(){
+	TEST_HEADER;
+	dentry_t dentry;
+	stat_t info;
+	uint32_t offset, page;
+	int shared = 0;
+
+	read_dentry_by_name((const uint8_t *) "verylargetextwithverylongname.tx", &dentry);
+	stat_dentry(&dentry, &info);
+	for (offset = 0; offset < info.length; offset += USER_PAGE_SIZE) {
+		page = image_page(dentry.inode_num, offset);
+		if (page != 0 && (page != (uint32_t) file_block_addr(dentry.inode_num, offset) || (page & (USER_PAGE_SIZE - 1)))) {
+			return FAIL;
+		}
+		shared += (page != 0);
+	}
+	printf("%d of %d pages mapped from the image\n", shared, (info.length + USER_PAGE_SIZE - 1) / USER_PAGE_SIZE);
+	return (image_page(dentry.inode_num, offset) == 0) ? PASS : FAIL;
+}
+
+/* fs_write_test
+ * Inputs: None
+ * Outputs: PASS on pass
+ * Side Effects: Uses fd 2 of a borrowed pcb, leaves the file system as it found it
+ * Coverage: creates a file, writes it across a block boundary, reads it back and unlinks it
+ */
+int fs_write_test(){
+	TEST_HEADER;
+	uint8_t buf[BYTES_PER_BLOCK + 1000];
+	uint8_t check[sizeof(buf)];
+	dentry_t dentry;
+	fd_t* file;
+	uint32_t free_inodes = fs_free_inode_count;
+	uint32_t free_blocks = fs_free_block_count;
+	int result = PASS;
+	int i;
+
+	for (i = 0; i < sizeof(buf); i++) {
+		buf[i] = 'a' + i % 26;
+	}
+	if (fs_create((const uint8_t *) "testfile") != 0 || fs_create((const uint8_t *) "testfile") != -1) {
+		return FAIL;
+	}
+	if (read_dentry_by_name((const uint8_t *) "testfile", &dentry) != 0) {
+		return FAIL;
+	}
+	file = &begin_fd_test()[2];
+	file->file_op_table_ptr = &file_ops;
+	file->inode = dentry.inode_num;
+	file->file_pos = 0;
+	file->cursor_block = NULL;
+	file->flags = IN_USE;
+
+	if (write_file(2, buf, 1000) != 1000 || write_file(2, buf + 1000, sizeof(buf) - 1000) != sizeof(buf) - 1000) {
+		result = FAIL;
+	}
+	if (fs_free_block_count != free_blocks - 2 || fs_free_inode_count != free_inodes - 1) {
+		result = FAIL;
+	}
+	file->file_pos = 0;
+	if (read_file(2, check, sizeof(check)) != sizeof(check)) {
+		result = FAIL;
+	}
+	for (i = 0; i < sizeof(buf); i++) {
+		if (buf[i] != check[i]) {
+			result = FAIL;
+			break;
+		}
+	}
+	file->flags = NOT_IN_USE;
+	end_fd_test();
+
+	if (fs_unlink((const uint8_t *) "testfile") != 0 || read_dentry_by_name((const uint8_t *) "testfile", &dentry) != -1) {
+		result = FAIL;
+	}
+	if (fs_free_block_count != free_blocks || fs_free_inode_count != free_inodes) {
+		result = FAIL;
+	}
+	printf("free inodes: %d, free data blocks: %d\n", fs_free_inode_count, fs_free_block_count);
+	return result;
+}
+
+/* A small extent format image: the boot block, 3 inodes and 8 data blocks */
+#define EXT_TEST_INODES 3
+#define EXT_TEST_BLOCKS 8
+static uint8_t extent_image[(1 + EXT_TEST_INODES + EXT_TEST_BLOCKS) * BYTES_PER_BLOCK];
+
+/* extent_fs_test
+ * Inputs: None
+ * Outputs: PASS on pass
+ * Side Effects: Switches to a test image and back to the real one, uses fd 2 of a borrowed pcb
+ * Coverage: extent format reads, a file growing past INODE_EXTENTS into an indirect block, unlink freeing it all.
+ *           "contig" is one extent over data blocks 0 and 1; "extents" has a full inode of one block extents
+ *           alternating between blocks 3 and 2, so its next block can't join the last extent.
+ */
+int extent_fs_test(){
+	TEST_HEADER;
+	boot_block_t* real_image = boot_block;
+	boot_block_t* image = (boot_block_t*) extent_image;
+	extent_inode_t* contig = (extent_inode_t*) (extent_image + 2 * BYTES_PER_BLOCK);
+	extent_inode_t* extents = (extent_inode_t*) (extent_image + 3 * BYTES_PER_BLOCK);
+	uint8_t* data = extent_image + (1 + EXT_TEST_INODES) * BYTES_PER_BLOCK;
+	uint8_t buf[200];
+	fd_t* file;
+	int result = PASS;
+	int i;
+
+	memset(extent_image, 0, sizeof(extent_image));
+	image->dir_count = 2;
+	image->inode_count = EXT_TEST_INODES;
+	image->data_count = EXT_TEST_BLOCKS;
+	*(uint32_t*) image->reserved = FS_EXTENT_MAGIC;
+	strcpy((int8_t*) image->direntries[0].filename, "contig");
+	image->direntries[0].filetype = REGULAR_FILE;
+	image->direntries[0].inode_num = 1;
+	strcpy((int8_t*) image->direntries[1].filename, "extents");
+	image->direntries[1].filetype = REGULAR_FILE;
+	image->direntries[1].inode_num = 2;
+
+	contig->length = BYTES_PER_BLOCK + 100;
+	contig->num_extents = 1;
+	contig->extents[0].start = 0;
+	contig->extents[0].length = 2;
+	for (i = 0; i < 2 * BYTES_PER_BLOCK; i++) {
+		data[i] = 'a' + i % 26;
+	}
+	extents->length = INODE_EXTENTS * BYTES_PER_BLOCK;
+	extents->num_extents = INODE_EXTENTS;
+	for (i = 0; i < INODE_EXTENTS; i++) {
+		extents->extents[i].start = (i % 2) ? 2 : 3;
+		extents->extents[i].length = 1;
+	}
+	memset(data + 2 * BYTES_PER_BLOCK, 'x', BYTES_PER_BLOCK);
+	memset(data + 3 * BYTES_PER_BLOCK, 'y', BYTES_PER_BLOCK);
+
+	init_file_sys((uint32_t) extent_image);
+	if (!extent_fs || fs_free_block_count != 4 || fs_free_inode_count != 0) {
+		result = FAIL;
+	}
+
+	/* across the end of the extent's first block, stopping at the end of the file */
+	if (read_data(1, BYTES_PER_BLOCK - 50, buf, sizeof(buf)) != 150) {
+		result = FAIL;
+	}
+	for (i = 0; i < 150; i++) {
+		if (buf[i] != 'a' + (BYTES_PER_BLOCK - 50 + i) % 26) {
+			result = FAIL;
+		}
+	}
+	if (read_data(2, (INODE_EXTENTS - 1) * BYTES_PER_BLOCK, buf, 1) != 1 || buf[0] != 'x' ||
+		read_data(2, (INODE_EXTENTS - 2) * BYTES_PER_BLOCK, buf, 1) != 1 || buf[0] != 'y') {
+		result = FAIL;
+	}
+
+	/* appending takes data block 4, and block 5 to hold the extent that no longer fits in the inode */
+	file = &begin_fd_test()[2];
+	file->file_op_table_ptr = &file_ops;
+	file->inode = 2;
+	file->file_pos = extents->length;
+	file->cursor_block = NULL;
+	file->flags = IN_USE;
+	if (write_file(2, "tail", 4) != 4) {
+		result = FAIL;
+	}
+	file->flags = NOT_IN_USE;
+	end_fd_test();
+	if (extents->num_extents != INODE_EXTENTS + 1 || extents->indirect_block != 5 || fs_free_block_count != 2) {
+		result = FAIL;
+	}
+	if (read_data(2, INODE_EXTENTS * BYTES_PER_BLOCK, buf, sizeof(buf)) != 4 || strncmp((int8_t*) buf, "tail", 4) != 0) {
+		result = FAIL;
+	}
+
+	/* its blocks, the shared ones, the new one and the indirect block all come back */
+	if (fs_unlink((const uint8_t *) "extents") != 0 || fs_free_block_count != 6 || fs_free_inode_count != 1) {
+		result = FAIL;
+	}
+
+	init_file_sys((uint32_t) real_image);
+	return result;
+}
+
+/* dir_cursor_test
+ * Inputs: None
+ * Outputs: PASS on pass
+ * Side Effects: Uses fds 2 and 3 of a borrowed pcb
+ * Coverage: two opens of the directory iterate independently, getdents returns every entry in one call
+ */
+int dir_cursor_test(){
+	TEST_HEADER;
+	fd_t* fds = begin_fd_test();
+	dirent_t entries[DIR_ENTRIES];
+	dentry_t dentry;
+	uint8_t name[FILENAME_LEN];
+	int result = PASS;
+	int count;
+	int i;
+
+	for (i = 2; i <= 3; i++) {
+		fds[i].file_op_table_ptr = &dir_ops;
+		fds[i].file_pos = 0;
+		fds[i].flags = IN_USE;
+	}
+
+	/* reading fd 2 must not move fd 3 */
+	read_directory(2, name, FILENAME_LEN);
+	read_directory(2, name, FILENAME_LEN);
+	read_directory(3, name, FILENAME_LEN);
+	read_dentry_by_index(0, &dentry);
+	if (strncmp((int8_t *) name, (int8_t *) dentry.filename, FILENAME_LEN) != 0 || fds[2].file_pos != 2) {
+		result = FAIL;
+	}
+
+	/* the whole directory in one call, then the end */
+	for (count = 0; read_dentry_by_index(count, &dentry) == 0; count++);
+	fds[3].file_pos = 0;
+	if (getdents_directory(3, entries, sizeof(entries)) != sizeof(dirent_t) * count ||
+		getdents_directory(3, entries, sizeof(entries)) != 0) {
+		result = FAIL;
+	}
+	fds[2].flags = NOT_IN_USE;
+	fds[3].flags = NOT_IN_USE;
+	end_fd_test();
+
+	for (i = 0; i < count && i < 3; i++) {
+		printf("%s type %d inode %d length %d\n", entries[i].filename, entries[i].filetype, entries[i].inode_num, entries[i].length);
+	}
+	return result;
+}
+
+/* stat_test
+ * Inputs: None
+ * Outputs: PASS on pass
+ * Side Effects: None
+ * Coverage: stat reports type, inode and length from the dentry and inode alone
+ */
+int stat_test(){
+	TEST_HEADER;
+	dentry_t dentry;
+	stat_t info;
+	int result = PASS;
+
+	read_dentry_by_name((uint8_t *) "frame0.txt", &dentry);
+	stat_dentry(&dentry, &info);
+	if (info.filetype != REGULAR_FILE || info.inode_num != dentry.inode_num || info.length == 0) {
+		result = FAIL;
+	}
+	printf("frame0.txt type %d inode %d length %d\n", info.filetype, info.inode_num, info.length);
+
+	read_dentry_by_name((uint8_t *) ".", &dentry);
+	stat_dentry(&dentry, &info);
+	if (info.filetype != DIRECTORY_FILE || info.inode_num != 0 || info.length != 0) {
+		result = FAIL;
+	}
+	return result;
+}
+
 /* open_file_test
  * Inputs: None
  * Outputs: PASS on pass
@@ -616,8 +1069,137 @@ void test_terminal_read_write(){
 // }
 
 /* Checkpoint 4 tests */
+
+/* tickless_idle_test()
+ * Inputs: None
+ * Outputs: PASS if the PIT stayed quiet
+ * Side Effects: Enables interrupts and halts for about a second of RTC interrupts
+ * Coverage: with nothing runnable the PIT should be stopped, so idle time costs no PIT interrupts,
+ *           EOIs or scheduler calls (a 100 Hz tick would have taken about 100)
+ */
+int tickless_idle_test() {
+	TEST_HEADER;
+	uint32_t pit_start = pit_interrupts;
+	uint32_t sched_start = sched_calls;
+	int halts;
+
+	sti();
+	for (halts = 0; halts < 8192; halts++) { // the RTC interrupts 8192 times a second
+		asm volatile("hlt");
+	}
+
+	printf("PIT interrupts: %d, scheduler calls: %d, PIT reprograms so far: %d\n",
+		pit_interrupts - pit_start, sched_calls - sched_start, pit_reprograms);
+	if (pit_interrupts != pit_start) {
+		return FAIL;
+	}
+	return PASS;
+}
+
+/* sched_idle_share_test()
+ * Inputs: None
+ * Outputs: PASS once the idle counter has moved
+ * Side Effects: Halts for about an eighth of a second of RTC interrupts
+ * Coverage: reports what share of CPU time was idle, i.e. how much CPU blocked RTC/terminal readers give
+ *           back instead of spinning, timed without PIT ticks
+ */
+int sched_idle_share_test() {
+	TEST_HEADER;
+	uint32_t idle_start = sched_idle_cycles;
+	uint32_t busy_start = sched_busy_cycles;
+	uint32_t idle, busy, share;
+	int halts;
+
+	cli();
+	for (halts = 0; halts < 1024; halts++) { // the RTC interrupts 8192 times a second
+		sched_halt();
+	}
+	sti();
+	idle = sched_idle_cycles - idle_start;
+	busy = sched_busy_cycles - busy_start;
+	share = (idle + busy >= 100) ? idle / ((idle + busy) / 100) : 0;
+
+	printf("idle cycles: %u, busy cycles: %u, idle share: %d%%\n", idle, busy, share);
+	return (idle != 0) ? PASS : FAIL;
+}
 /* Checkpoint 5 tests */
 
+/* frame_alloc_test()
+ * Inputs: None
+ * Outputs: PASS if frames come out distinct, aligned, above the kernel, and go back
+ * Side Effects: None
+ * Coverage: physical frame allocator set up from the multiboot memory map
+ */
+int frame_alloc_test() {
+	TEST_HEADER;
+	uint32_t free_start = free_frame_count;
+	uint32_t first, second;
+	int result = PASS;
+
+	first = alloc_frame();
+	second = alloc_frame();
+	if (first == NO_FRAME || second == NO_FRAME || first == second) {
+		result = FAIL;
+	}
+	if (first < FRAME_ALLOC_START || (first & (FRAME_SIZE - 1)) || (second & (FRAME_SIZE - 1))) {
+		result = FAIL;
+	}
+	free_frame(first);
+	free_frame(second);
+	free_frame(second); // freeing twice must not count the frame twice
+	if (free_frame_count != free_start) {
+		result = FAIL;
+	}
+	printf("free frames: %d (%d MB)\n", free_frame_count, free_frame_count / (0x100000 / FRAME_SIZE));
+	return result;
+}
+
+/* console_flush_test()
+ * Inputs: None
+ * Outputs: PASS if text written through putbuf reaches the terminal's page of text memory
+ * Side Effects: Prints a line on terminal 0
+ * Coverage: console rows, dirty rows, flush of the kernel's own output before any process runs
+ */
+int console_flush_test() {
+	TEST_HEADER;
+	uint16_t* page = (uint16_t*) VIDEO; // terminal 0's page
+	int32_t row;
+
+	putbuf(0, (const uint8_t*) "\nflush", 6);
+	row = terminal_array[0].screen_y;
+	if (console_dirty() || (page[row * NUM_COLS] & 0xFF) != 'f' || (page[row * NUM_COLS + 4] & 0xFF) != 'h') {
+		return FAIL;
+	}
+	putc('\n');
+	return PASS;
+}
+
+/* scrollback_test()
+ * Inputs: None
+ * Outputs: PASS if a line that scrolled off terminal 0 comes back when its view moves into the scrollback
+ * Side Effects: Prints 51 lines on terminal 0
+ * Coverage: scrollback ring, scroll_view, view_live
+ */
+int scrollback_test() {
+	TEST_HEADER;
+	uint16_t* page = (uint16_t*) VIDEO; // terminal 0's page
+	uint16_t* bottom = page + (NUM_ROWS - 1) * NUM_COLS;
+	uint8_t newlines[NUM_ROWS];
+	int32_t shown;
+
+	memset(newlines, '\n', NUM_ROWS);
+	putbuf(0, newlines, NUM_ROWS);	// the cursor is now on the bottom row
+	putbuf(0, (const uint8_t*) "mark", 4);
+	putbuf(0, newlines, NUM_ROWS);	// "mark" is one row above the screen
+	scroll_view(0, NUM_ROWS);
+	shown = (bottom[0] & 0xFF) == 'm' && (bottom[3] & 0xFF) == 'k';
+	view_live(0);
+	if (!shown || (bottom[0] & 0xFF) == 'm') {
+		return FAIL;
+	}
+	return PASS;
+}
+
 
 /* Test suite entry point */
 void launch_tests(){
@@ -636,6 +1218,14 @@ void launch_tests(){
 	/* Checkpoint 2 tests*/
 	TEST_OUTPUT("read_dentry_test", read_dentry_test());
 	// TEST_OUTPUT("read_data_test", read_data_test());
+	// TEST_OUTPUT("read_data_timing_test", read_data_timing_test());
+	// TEST_OUTPUT("read_file_cursor_test", read_file_cursor_test());
+	// TEST_OUTPUT("lseek_pread_test", lseek_pread_test());
+	// TEST_OUTPUT("image_page_test", image_page_test());
+	// TEST_OUTPUT("fs_write_test", fs_write_test());
+	// TEST_OUTPUT("extent_fs_test", extent_fs_test());
+	// TEST_OUTPUT("dir_cursor_test", dir_cursor_test());
+	// TEST_OUTPUT("stat_test", stat_test());
 	// TEST_OUTPUT("open_read_file_test", open_read_file_test());
 	// test_terminal_read_write(); /* Comment this out if you want to separately test read/write of terminal. */
 	// TEST_OUTPUT("test_terminal_read_write", test_terminal_open_close());
@@ -646,6 +1236,15 @@ void launch_tests(){
 	// TEST_OUTPUT("RTC_frequencies_invalid_test", RTC_frequencies_invalid_test());
 	// TEST_OUTPUT("RTC_open_close_test", RTC_open_close_test());
 
+	/* Checkpoint 4 tests */
+	// TEST_OUTPUT("tickless_idle_test", tickless_idle_test());
+	// TEST_OUTPUT("sched_idle_share_test", sched_idle_share_test());
+
+	/* Checkpoint 5 tests */
+	// TEST_OUTPUT("frame_alloc_test", frame_alloc_test());
+	// TEST_OUTPUT("console_flush_test", console_flush_test());
+	// TEST_OUTPUT("scrollback_test", scrollback_test());
+
 	
 	
 	
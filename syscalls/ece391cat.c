@@ -7,6 +7,8 @@ int main ()
 {
     int32_t fd, cnt;
     uint8_t buf[1024];
+    ece391_stat_t st;
+    uint8_t* data;
 
     if (0 != ece391_getargs (buf, 1024)) {
         ece391_fdputs (1, (uint8_t*)"could not read arguments\n");
@@ -18,6 +20,14 @@ int main ()
 	return 2;
     }
 
+    /* a regular file is mapped and written out in one go */
+    if (0 == ece391_fstat (fd, &st) && ECE391_REGULAR_FILE == st.type &&
+	0 != st.length && MAP_FAILED != (data = ece391_mmap (fd, 0, st.length))) {
+	cnt = ece391_write (1, data, st.length);
+	ece391_munmap (data, st.length);
+	return (-1 == cnt) ? 3 : 0;
+    }
+
     while (0 != (cnt = ece391_read (fd, buf, 1024))) {
         if (-1 == cnt) {
 	    ece391_fdputs (1, (uint8_t*)"file read failed\n");
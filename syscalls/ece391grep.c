@@ -6,17 +6,15 @@
 #define BUFSIZE 1024
 #define SBUFSIZE 33
 
+/* Prints the lines read from fd that contain s, each after "fname:"
+   unless fname is empty. */
 int32_t
-do_one_file (const char* s, const char* fname) 
+do_one_fd (const char* s, int32_t fd, const char* fname) 
 {
-    int32_t fd, cnt, last, line_start, line_end, check, s_len;
+    int32_t cnt, last, line_start, line_end, check, s_len;
     uint8_t data[BUFSIZE+1];
 
     s_len = ece391_strlen ((uint8_t*)s);
-    if (-1 == (fd = ece391_open ((uint8_t*)fname))) {
-        ece391_fdputs (1, (uint8_t*)"file open failed\n");
-        return -1;
-    }
     last = 0;
     while (1) {
         cnt = ece391_read (fd, data + last, BUFSIZE - last);
@@ -42,8 +40,10 @@ do_one_file (const char* s, const char* fname)
 	    for (check = line_start; check < line_end; check++) {
 		if (s[0] == data[check] && 
 		    0 == ece391_strncmp ((uint8_t*)(data + check), (uint8_t*)s, s_len)) {
-		    ece391_fdputs (1, (uint8_t*)fname);
-		    ece391_fdputs (1, (uint8_t*)":");
+		    if ('\0' != fname[0]) {
+			ece391_fdputs (1, (uint8_t*)fname);
+			ece391_fdputs (1, (uint8_t*)":");
+		    }
 		    ece391_fdputs (1, data + line_start);
 		    ece391_fdputs (1, (uint8_t*)"\n");
 		    break;
@@ -58,6 +58,20 @@ do_one_file (const char* s, const char* fname)
 	if (0 == cnt)
 	    break;
     }
+    return 0;
+}
+
+int32_t
+do_one_file (const char* s, const char* fname) 
+{
+    int32_t fd;
+
+    if (-1 == (fd = ece391_open ((uint8_t*)fname))) {
+        ece391_fdputs (1, (uint8_t*)"file open failed\n");
+        return -1;
+    }
+    if (0 != do_one_fd (s, fd, fname))
+        return -1;
     if (-1 == ece391_close (fd)) {
         ece391_fdputs (1, (uint8_t*)"file close failed\n");
         return -1;
@@ -70,12 +84,18 @@ int main ()
     int32_t fd, cnt;
     uint8_t buf[SBUFSIZE];
     uint8_t search[BUFSIZE];
+    ece391_stat_t st;
 
     if (0 != ece391_getargs (search, BUFSIZE)) {
         ece391_fdputs (1, (uint8_t*)"could not read argument\n");
         return 3;
     }
 
+    /* on the end of a pipe, search what comes through it instead of the
+       files */
+    if (0 == ece391_fstat (0, &st) && ECE391_PIPE_FILE == st.type)
+	return (0 == do_one_fd ((char*)search, 0, "")) ? 0 : 3;
+
     if (-1 == (fd = ece391_open ((uint8_t*)"."))) {
         ece391_fdputs (1, (uint8_t*)"directory open failed\n");
 	return 2;
@@ -3,26 +3,33 @@
 #include "ece391support.h"
 #include "ece391syscall.h"
 
-#define SBUFSIZE 33
+#define NAMELEN 32
+#define MAXENTRIES 63
 
 int main ()
 {
-    int32_t fd, cnt;
-    uint8_t buf[SBUFSIZE];
+    int32_t fd, cnt, i, len;
+    ece391_dirent_t entries[MAXENTRIES];
+    uint8_t buf[NAMELEN + 1];
 
     if (-1 == (fd = ece391_open ((uint8_t*)"."))) {
         ece391_fdputs (1, (uint8_t*)"directory open failed\n");
         return 2;
     }
 
-    while (0 != (cnt = ece391_read (fd, buf, SBUFSIZE-1))) {
+    /* the whole directory fits in one getdents call */
+    while (0 != (cnt = ece391_getdents (fd, entries, sizeof (entries)))) {
         if (-1 == cnt) {
 	        ece391_fdputs (1, (uint8_t*)"directory entry read failed\n");
 	        return 3;
 	    }
-	    buf[cnt] = '\n';
-	    if (-1 == ece391_write (1, buf, cnt + 1))
-	        return 3;
+	    for (i = 0; i < cnt / (int32_t)sizeof (ece391_dirent_t); i++) {
+	        for (len = 0; len < NAMELEN && '\0' != entries[i].name[len]; len++)
+		    buf[len] = entries[i].name[len];
+	        buf[len] = '\n';
+	        if (-1 == ece391_write (1, buf, len + 1))
+	            return 3;
+	    }
     }
 
     return 0;
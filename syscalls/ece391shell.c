@@ -4,14 +4,86 @@
 #include "ece391syscall.h"
 
 #define BUFSIZE 1024
+#define NOT_FOUND 127   /* halt status of a pipeline side whose command doesn't exist */
+
+/* Prints "[pid] msg" for a background job. */
+static void
+job_message (int32_t pid, const char* msg)
+{
+    uint8_t num[12];
+
+    ece391_fdputs (1, (uint8_t*)"[");
+    ece391_fdputs (1, ece391_itoa (pid, num, 10));
+    ece391_fdputs (1, (uint8_t*)"]");
+    ece391_fdputs (1, (uint8_t*)msg);
+}
+
+/* Runs a command in a forked copy of the shell and halts with its status. */
+static void
+run_child (uint8_t* cmd)
+{
+    int32_t rval = ece391_execute (cmd);
+
+    if (-1 == rval)
+	ece391_halt (NOT_FOUND);
+    /* the kernel turns 255 back into 256 */
+    ece391_halt (256 == rval ? 255 : rval);
+}
+
+/* Runs "left | right", each side in a forked copy of the shell with the
+   pipe on its stdout or stdin.  Returns the first failing side's status,
+   in the same form execute returns. */
+static int32_t
+run_pipeline (uint8_t* left, uint8_t* right)
+{
+    int32_t fds[2], writer, reader, lval, rval;
+
+    if (-1 == ece391_pipe (fds))
+	return -1;
+    if (-1 == (writer = ece391_fork ())) {
+	ece391_close (fds[0]);
+	ece391_close (fds[1]);
+	return -1;
+    }
+    if (0 == writer) {
+	ece391_dup2 (fds[1], 1);
+	ece391_close (fds[0]);
+	ece391_close (fds[1]);
+	run_child (left);
+    }
+    if (-1 == (reader = ece391_fork ())) {
+	/* nobody reads, so the writer fails instead of blocking */
+	ece391_close (fds[0]);
+	ece391_close (fds[1]);
+	ece391_waitpid (writer, &lval, 0);
+	return -1;
+    }
+    if (0 == reader) {
+	ece391_dup2 (fds[0], 0);
+	ece391_close (fds[0]);
+	ece391_close (fds[1]);
+	run_child (right);
+    }
+    /* the children hold the only ends left, so each side sees the other finish */
+    ece391_close (fds[0]);
+    ece391_close (fds[1]);
+    ece391_waitpid (writer, &lval, 0);
+    ece391_waitpid (reader, &rval, 0);
+    if (0 == rval)
+	rval = lval;
+    return NOT_FOUND == rval ? -1 : rval;
+}
 
 int main ()
 {
-    int32_t cnt, rval;
+    int32_t cnt, rval, pid, background, bar;
     uint8_t buf[BUFSIZE];
     ece391_fdputs (1, (uint8_t*)"Starting 391 Shell\n");
 
     while (1) {
+	/* reap background jobs that have finished */
+	while (0 < (pid = ece391_waitpid (WAIT_ANY, &rval, WNOHANG)))
+	    job_message (pid, " done\n");
         ece391_fdputs (1, (uint8_t*)"391OS> ");
 	if (-1 == (cnt = ece391_read (0, buf, BUFSIZE-1))) {
 	    ece391_fdputs (1, (uint8_t*)"read from keyboard failed\n");
@@ -22,9 +94,32 @@ int main ()
 	buf[cnt] = '\0';
 	if (0 == ece391_strcmp (buf, (uint8_t*)"exit"))
 	    return 0;
+	/* a trailing '&' runs the command in the background */
+	background = 0;
+	while (cnt > 0 && ' ' == buf[cnt - 1])
+	    buf[--cnt] = '\0';
+	if (cnt > 0 && '&' == buf[cnt - 1]) {
+	    background = 1;
+	    buf[--cnt] = '\0';
+	    while (cnt > 0 && ' ' == buf[cnt - 1])
+		buf[--cnt] = '\0';
+	}
 	if ('\0' == buf[0])
 	    continue;
-	rval = ece391_execute (buf);
+	if (background) {
+	    if (-1 == (pid = ece391_spawn (buf)))
+		ece391_fdputs (1, (uint8_t*)"no such command\n");
+	    else
+		job_message (pid, "\n");
+	    continue;
+	}
+	/* "left | right" pipes left's output into right */
+	for (bar = 0; '\0' != buf[bar] && '|' != buf[bar]; bar++);
+	if ('|' == buf[bar]) {
+	    buf[bar] = '\0';
+	    rval = run_pipeline (buf, buf + bar + 1);
+	} else
+	    rval = ece391_execute (buf);
 	if (-1 == rval)
 	    ece391_fdputs (1, (uint8_t*)"no such command\n");
 	else if (256 == rval)
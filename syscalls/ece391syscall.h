@@ -21,6 +21,57 @@ extern int32_t ece391_getargs (uint8_t* buf, int32_t nbytes);
 extern int32_t ece391_vidmap (uint8_t** screen_start);
 extern int32_t ece391_set_handler (int32_t signum, void* handler);
 extern int32_t ece391_sigreturn (void);
+extern int32_t ece391_set_priority (int32_t priority);
+extern int32_t ece391_fork (void);
+extern int32_t ece391_spawn (const uint8_t* command);
+extern int32_t ece391_waitpid (int32_t pid, int32_t* status, int32_t options);
+extern int32_t ece391_wait (int32_t* status);
+extern int32_t ece391_pipe (int32_t fds[2]);
+extern int32_t ece391_dup2 (int32_t oldfd, int32_t newfd);
+extern int32_t ece391_create (const uint8_t* filename);
+extern int32_t ece391_unlink (const uint8_t* filename);
+extern int32_t ece391_getdents (int32_t fd, void* buf, int32_t nbytes);
+extern int32_t ece391_stat (const uint8_t* filename, void* buf);
+extern int32_t ece391_fstat (int32_t fd, void* buf);
+extern int32_t ece391_lseek (int32_t fd, int32_t offset, int32_t whence);
+extern int32_t ece391_pread (int32_t fd, void* buf, int32_t nbytes, int32_t offset);
+extern void* ece391_mmap (int32_t fd, int32_t offset, int32_t length);
+extern int32_t ece391_munmap (void* addr, int32_t length);
+
+/* One directory entry as getdents returns it.  The name is only
+   null terminated when it is shorter than 32 characters. */
+typedef struct ece391_dirent {
+    uint8_t name[32];
+    uint32_t type;          /* 0 RTC, 1 directory, 2 regular file */
+    uint32_t inode;
+    uint32_t length;        /* bytes, 0 unless a regular file */
+} ece391_dirent_t;
+
+/* What stat and fstat return.  stat only sees the first three types;
+   fstat also reports the terminal and pipes. */
+typedef struct ece391_stat {
+    uint32_t type;          /* one of the types below */
+    uint32_t inode;         /* 0 unless a regular file */
+    uint32_t length;        /* bytes in a regular file or waiting in a pipe */
+} ece391_stat_t;
+
+#define ECE391_RTC_FILE       0
+#define ECE391_DIRECTORY_FILE 1
+#define ECE391_REGULAR_FILE   2
+#define ECE391_TERMINAL_FILE  3
+#define ECE391_PIPE_FILE      4
+
+/* what mmap returns when it fails */
+#define MAP_FAILED ((void*)-1)
+
+/* lseek: what the offset is relative to */
+#define SEEK_SET 0
+#define SEEK_CUR 1
+#define SEEK_END 2
+
+/* waitpid: pid to wait for any child, and the option not to block */
+#define WAIT_ANY (-1)
+#define WNOHANG  1
 
 enum signums {
 	DIV_ZERO = 0,
@@ -11,5 +11,21 @@
 #define SYS_VIDMAP  8
 #define SYS_SET_HANDLER  9
 #define SYS_SIGRETURN  10
+#define SYS_SET_PRIORITY  11
+#define SYS_FORK  12
+#define SYS_SPAWN  13
+#define SYS_WAITPID  14
+#define SYS_WAIT  15
+#define SYS_PIPE  16
+#define SYS_DUP2  17
+#define SYS_CREATE  18
+#define SYS_UNLINK  19
+#define SYS_GETDENTS  20
+#define SYS_STAT  21
+#define SYS_FSTAT  22
+#define SYS_LSEEK  23
+#define SYS_PREAD  24
+#define SYS_MMAP  25
+#define SYS_MUNMAP  26
 
 #endif /* ECE391SYSNUM_H */